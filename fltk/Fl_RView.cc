@@ -23,19 +23,109 @@ extern Fl_RViewUI *rviewUI;
 Fl_RView::Fl_RView(int x, int y, int w, int h, const char *name) : Fl_Gl_Window(x, y, w, h, name)
 {
   v = new RView(w, h);
+
+  _pendingMouse  = false;
+  _pendingMouseX = 0;
+  _pendingMouseY = 0;
+  _pendingWheel  = 0;
+  _pendingWheelX = 0;
+  _pendingWheelY = 0;
+  _pendingUpdate = false;
+  _pendingROI    = 0;
+  _pendingROIX   = 0;
+  _pendingROIY   = 0;
+  _resizePending = false;
+}
+
+void Fl_RView::cb_resize(void *data)
+{
+  Fl_RView *o = (Fl_RView *)data;
+
+  o->_resizePending = true;
+  o->redraw();
 }
 
 void Fl_RView::draw()
 {
-  if (!valid()) {
-    v->Resize(w(), h());
+  if ((!valid()) || (_resizePending == true)) {
+    if ((_resizePending == true) || ((w() == v->GetWidth()) && (h() == v->GetHeight()))) {
+      Fl::remove_timeout(cb_resize, this);
+      _resizePending = false;
+      v->Resize(w(), h());
+    } else {
+      // Keep showing the current images until the window size has settled
+      Fl::remove_timeout(cb_resize, this);
+      Fl::add_timeout(FL_RVIEW_RESIZE_DELAY, cb_resize, this);
+      v->Clip();
+    }
   }
+  this->FlushPendingEvents();
   v->Draw();
 }
 
+void Fl_RView::FlushPendingEvents()
+{
+  unsigned int i;
+  bool update, info;
+
+  update = _pendingUpdate;
+  info   = false;
+  _pendingUpdate = false;
+
+  // Contour points are applied in the order in which they arrived
+  if (_pendingContour.size() > 0) {
+    for (i = 0; i < _pendingContour.size(); i++) {
+      v->AddContour(_pendingContour[i].first, _pendingContour[i].second, NewPoint);
+    }
+    _pendingContour.clear();
+    update = true;
+  }
+
+  // Only the latest ROI corner matters
+  if (_pendingROI == 1) {
+    v->UpdateROI1(_pendingROIX, _pendingROIY);
+    update = true;
+  } else if (_pendingROI == 2) {
+    v->UpdateROI2(_pendingROIX, _pendingROIY);
+    update = true;
+  }
+  _pendingROI = 0;
+
+  // Wheel ticks are accumulated and applied as a single step
+  if (_pendingWheel != 0) {
+    v->MouseWheel(_pendingWheelX, _pendingWheelY, _pendingWheel);
+    _pendingWheel = 0;
+    update = true;
+  }
+
+  // Only the latest mouse position matters
+  if (_pendingMouse == true) {
+    v->MousePosition(_pendingMouseX, _pendingMouseY);
+    _pendingMouse = false;
+    info = true;
+  }
+
+  if (update == true) {
+    v->Update();
+  }
+  if ((update == true) || (info == true)) {
+    rviewUI->update();
+  }
+}
+
 int Fl_RView::handle(int event)
 {
-  char buffer1[256], buffer2[256], buffer3[256], buffer4[256], buffer5[256];
+  // Apply queued input first so that discrete events are seen in order
+  switch (event) {
+  case FL_KEYBOARD:
+  case FL_SHORTCUT:
+  case FL_PUSH:
+  case FL_RELEASE:
+    this->FlushPendingEvents();
+    break;
+  default:
+    break;
+  }
 
   switch (event) {
   case FL_KEYBOARD:
@@ -68,6 +158,7 @@ int Fl_RView::handle(int event)
         return 1;
       } else {
         v->FillContour(rviewUI->_id, 0);
+        if (rviewUI->_histogramWindow != NULL) rviewUI->_histogramWindow->update(v->GetLabelChanges());
         v->ClearContour();
         v->SegmentationLabelsOn();
         v->SegmentationUpdateOn();
@@ -135,29 +226,23 @@ int Fl_RView::handle(int event)
     }
     break;
   case FL_DRAG:
+    // Queue the event, it is applied once per frame in draw()
     if ((Fl::event_state() & (FL_BUTTON1 | FL_SHIFT)) == (FL_BUTTON1 | FL_SHIFT)) {
-      v->AddContour(Fl::event_x(), Fl::event_y(), NewPoint);
-      v->Update();
-      rviewUI->info_voxel->value(buffer1);
-      rviewUI->info_world->value(buffer2);
-      rviewUI->info_target->value(buffer3);
-      rviewUI->info_source->value(buffer4);
-      rviewUI->info_segmentation->value(buffer5);
-      rviewUI->update();
+      _pendingContour.push_back(std::make_pair(Fl::event_x(), Fl::event_y()));
       this->redraw();
       return 1;
     }
     if ((Fl::event_state() & (FL_BUTTON1 | FL_CTRL)) == (FL_BUTTON1 | FL_CTRL)) {
-      v->UpdateROI1(Fl::event_x(), Fl::event_y());
-      v->Update();
-      rviewUI->update();
+      _pendingROI  = 1;
+      _pendingROIX = Fl::event_x();
+      _pendingROIY = Fl::event_y();
       this->redraw();
       return 1;
     }
     if ((Fl::event_state() & (FL_BUTTON3 | FL_CTRL)) == (FL_BUTTON3 | FL_CTRL)) {
-      v->UpdateROI2(Fl::event_x(), Fl::event_y());
-      v->Update();
-      rviewUI->update();
+      _pendingROI  = 2;
+      _pendingROIX = Fl::event_x();
+      _pendingROIY = Fl::event_y();
       this->redraw();
       return 1;
     }
@@ -172,15 +257,22 @@ int Fl_RView::handle(int event)
     }
     return 0;
   case FL_MOVE:
-    v->MousePosition(Fl::event_x(), Fl::event_y());
-    rviewUI->update();
+    _pendingMouse  = true;
+    _pendingMouseX = Fl::event_x();
+    _pendingMouseY = Fl::event_y();
     this->redraw();
     return 1;
     break;
   case FL_MOUSEWHEEL:
-    v->MouseWheel(Fl::event_x(), Fl::event_y(), Fl::event_dy());
-    v->Update();
-    rviewUI->update();
+    // Steps at another position are applied about that position before accumulating new ones
+    if ((_pendingWheel != 0) && ((_pendingWheelX != Fl::event_x()) || (_pendingWheelY != Fl::event_y()))) {
+      v->MouseWheel(_pendingWheelX, _pendingWheelY, _pendingWheel);
+      _pendingWheel  = 0;
+      _pendingUpdate = true;
+    }
+    _pendingWheel += Fl::event_dy();
+    _pendingWheelX = Fl::event_x();
+    _pendingWheelY = Fl::event_y();
     this->redraw();
     return 1;
     break;
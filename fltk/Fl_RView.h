@@ -28,10 +28,42 @@
 
 #include <RView.h>
 
+#include <utility>
+#include <vector>
+
+/// Delay in seconds after the last resize event before reslicing
+#define FL_RVIEW_RESIZE_DELAY 0.1
+
 
 class Fl_RView : public Fl_Gl_Window
 {
 
+protected:
+
+  /// Flag whether a mouse position has not yet been applied
+  bool _pendingMouse;
+
+  /// Latest mouse position which has not yet been applied
+  int _pendingMouseX, _pendingMouseY;
+
+  /// Accumulated mouse wheel delta at the same position which has not yet been applied
+  int _pendingWheel, _pendingWheelX, _pendingWheelY;
+
+  /// Flag whether wheel steps have been applied but the viewer has not yet been updated
+  bool _pendingUpdate;
+
+  /// Latest ROI corner which has not yet been applied (1 or 2, 0 if none)
+  int _pendingROI, _pendingROIX, _pendingROIY;
+
+  /// Contour points queued since the last frame
+  std::vector<std::pair<int, int> > _pendingContour;
+
+  /// Flag whether the window size has settled and reslicing is due
+  bool _resizePending;
+
+  /// Callback which is called once the window size has settled
+  static void cb_resize(void *);
+
 public:
 
   /// Pointer to the registration viewer
@@ -46,6 +78,9 @@ public:
   /// Default function to handle events
   int  handle(int);
 
+  /// Apply all pending input events with a single update of the viewer
+  void FlushPendingEvents();
+
 };
 
 #endif
@@ -157,8 +157,16 @@ void Fl_RViewUI::cb_viewCursorMode(Fl_Button *, void* v)
   viewer->redraw();
 }
 
+void Fl_RViewUI::cb_update(void *data)
+{
+  ((Fl_RViewUI *)data)->updateNow();
+}
+
 Fl_RViewUI::Fl_RViewUI()
 {
+  // No refresh of the windows requested yet
+  _updatePending = false;
+
   // Create main window
   Fl_Window* o = mainWindow = new Fl_Window(1060, 780, "rview");
   o->labeltype(FL_NORMAL_LABEL);
@@ -505,24 +513,47 @@ void Fl_RViewUI::show()
   settingsWindow->end();
 
   // Update viewer
-  this->update();
+  this->updateNow();
 
   // Show the main window
   mainWindow->show();
 }
 
+/// Set value of output widget only if it changed to avoid needless redraws
+static void SetOutputValue(Fl_Output *o, const char *value)
+{
+  if ((o->value() == NULL) || (strcmp(o->value(), value) != 0)) {
+    o->value(value);
+  }
+}
+
 void Fl_RViewUI::update()
+{
+  // Coalesce all requests until the next refresh is due
+  if (_updatePending == false) {
+    _updatePending = true;
+    Fl::add_timeout(_UI_REFRESH_INTERVAL, cb_update, this);
+  }
+}
+
+void Fl_RViewUI::updateNow()
 {
   double x, y, z;
   char buffer1[256], buffer2[256], buffer3[256], buffer4[256], buffer5[256];
 
+  // Cancel any pending refresh as it is done now
+  if (_updatePending == true) {
+    Fl::remove_timeout(cb_update, this);
+    _updatePending = false;
+  }
+
   // Update info
   viewer->v->GetInfoText(buffer1, buffer2, buffer3, buffer4, buffer5);
-  info_voxel->value(buffer1);
-  info_world->value(buffer2);
-  info_target->value(buffer3);
-  info_source->value(buffer4);
-  info_segmentation->value(buffer5);
+  SetOutputValue(info_voxel, buffer1);
+  SetOutputValue(info_world, buffer2);
+  SetOutputValue(info_target, buffer3);
+  SetOutputValue(info_source, buffer4);
+  SetOutputValue(info_segmentation, buffer5);
   info_snap_to_grid->value(rview->GetSnapToGrid());
   info_cursor->value(rview->GetDisplayCursor());
 
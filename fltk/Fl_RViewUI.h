@@ -39,6 +39,7 @@
 #include <FL/Fl_Hold_Browser.H>
 #include <FL/Fl_Check_Browser.H>
 #include <FL/Fl_Output.H>
+#include <FL/Fl_Progress.H>
 #include <FL/Fl_Multiline_Output.H>
 #include <FL/Fl_Text_Display.H>
 #include <FL/Fl_Return_Button.H>
@@ -68,6 +69,9 @@
 #define _GLOBAL_ROTATION_MIN    -180
 #define _GLOBAL_ROTATION_MAX     180
 
+// Minimum interval in seconds between two refreshes of the windows
+#define _UI_REFRESH_INTERVAL     (1.0 / 60.0)
+
 class Fl_RViewUI
 {
 
@@ -101,6 +105,9 @@ class Fl_RViewUI
   /// Widget for tabs
   Fl_Tabs *tab_menu;
 
+  /// Flag whether a refresh of the windows has been requested
+  bool _updatePending;
+
   //
   // Callback methods
   //
@@ -115,6 +122,7 @@ class Fl_RViewUI
   static void cb_viewCursor(Fl_Check_Button*, void*);
   static void cb_snapGrid(Fl_Check_Button*, void*);
   static void cb_viewCursorMode(Fl_Button*, void*);
+  static void cb_update(void *);
 
 public:
 
@@ -124,9 +132,12 @@ public:
   /// Show the windows
   void show();
 
-  /// Update the windows
+  /// Request an update of the windows (done at most once per frame)
   void update();
 
+  /// Update the windows immediately
+  void updateNow();
+
   /// Initialize the main window
   void InitializeMainWindow();
 
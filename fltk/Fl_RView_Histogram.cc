@@ -36,12 +36,19 @@ void Fl_HistogramWindow::recalculate()
   _histogramWindow.CalculateHistograms();
 }
 
+void Fl_HistogramWindow::update(const std::vector<LabelChange> &changes)
+{
+  _histogramWindow.UpdateHistograms(changes);
+  if (this->shown()) this->redraw();
+}
+
 void Fl_HistogramWindow::draw()
 {
-  int i, j;
+  int i, j, l;
   char buffer[256], buffer2[256];
   unsigned char r, g, b;
   double x, y, ox, oy;
+  SegmentTable *table;
 
   // Clear everything
   make_current();
@@ -88,13 +95,15 @@ void Fl_HistogramWindow::draw()
   }
 
   // Draw histogram for each structure
-  for (j = 0; j < SHRT_MAX+1; j++) {
+  table = _v->GetSegmentTable();
+  for (l = 0; l < table->NumberOfSegments(); l++) {
+    j = table->GetSegmentId(l);
 
-    // Check if structure is visible
-    if ((_v->GetSegmentTable()->GetVisibility(j)) && (_v->GetSegmentTable()->IsValid(j))) {
+    // Check if structure is visible and its histogram has been computed
+    if ((table->GetVisibility(j)) && (_histogramWindow._localHistogram.count(j) > 0)) {
 
       // Set up FL drawing colour style
-      _v->GetSegmentTable()->GetColor(j,&r,&g,&b);
+      table->GetColor(j,&r,&g,&b);
       fl_color(r,g,b);
       fl_line_style(FL_SOLID, 0);
 
@@ -123,3 +132,67 @@ void Fl_HistogramWindow::position(int nbin, int nhistogram, double& x, double& y
   y = ((_maxHistogram - y) /_maxHistogram)*(h() - 30) + 10;
 }
 
+Fl_ROIStatisticsWindow::Fl_ROIStatisticsWindow(int x, int y, int w, int h, const char *name, RView *viewer) : Fl_Window(x, y, w, h, name)
+{
+  _v = viewer;
+}
+
+Fl_ROIStatisticsWindow::~Fl_ROIStatisticsWindow()
+{
+}
+
+void Fl_ROIStatisticsWindow::draw()
+{
+  // Clear everything
+  make_current();
+  fl_draw_box(FL_FLAT_BOX, 0, 0, w(), h(), FL_WHITE);
+
+  // Statistics are recomputed only if the ROI or frame changed
+  this->drawStatistics("Target", _v->GetTargetROIStatistics(), 0, h() / 2);
+  this->drawStatistics("Source", _v->GetSourceROIStatistics(), h() / 2, h() - h() / 2);
+}
+
+void Fl_ROIStatisticsWindow::drawStatistics(const char *name, const ROIStatistics *statistics, int y, int height)
+{
+  int i, x1, x2, bar, maxHistogram;
+  char buffer[256];
+
+  fl_color(0,0,0);
+  fl_line_style(FL_SOLID, 0);
+  if (statistics->GetCount() == 0) {
+    sprintf(buffer, "%s: no voxels in ROI", name);
+    fl_draw(buffer, 10, y + 15);
+    return;
+  }
+
+  // Draw summary
+  sprintf(buffer, "%s: %d voxels, mean = %.2f, std = %.2f", name,
+          statistics->GetCount(), statistics->GetMean(), statistics->GetSigma());
+  fl_draw(buffer, 10, y + 15);
+  sprintf(buffer, "5%% = %.2f, median = %.2f, 95%% = %.2f", statistics->Percentile(5),
+          statistics->Percentile(50), statistics->Percentile(95));
+  fl_draw(buffer, 10, y + 30);
+
+  // Compute maximum in histogram
+  const std::vector<int> &histogram = statistics->GetHistogram();
+  maxHistogram = 0;
+  for (i = 0; i < ROI_STATISTICS_BINS; i++) {
+    if (histogram[i] > maxHistogram) maxHistogram = histogram[i];
+  }
+
+  // Draw histogram
+  fl_color(128,128,128);
+  for (i = 0; i < ROI_STATISTICS_BINS; i++) {
+    x1  = 10 + i * (w() - 20) / ROI_STATISTICS_BINS;
+    x2  = 10 + (i + 1) * (w() - 20) / ROI_STATISTICS_BINS;
+    bar = round(double(histogram[i]) / maxHistogram * (height - 60));
+    if (bar > 0) fl_rectf(x1, y + height - 20 - bar, x2 - x1, bar);
+  }
+
+  // Draw intensity range of histogram
+  fl_color(0,0,0);
+  sprintf(buffer, "%.2f", statistics->BinToValue(0));
+  fl_draw(buffer, 10, y + height - 5);
+  sprintf(buffer, "%.2f", statistics->BinToValue(ROI_STATISTICS_BINS));
+  fl_draw(buffer, w() - 10 - int(fl_width(buffer)), y + height - 5);
+}
@@ -52,6 +52,33 @@ public:
   /// Recalculate histogram
   void recalculate();
 
+  /// Update histogram after segmentation voxels have changed
+  void update(const std::vector<LabelChange> &);
+
+};
+
+class Fl_ROIStatisticsWindow : public Fl_Window
+{
+
+protected:
+
+  /// Draw statistics of an image in part of the window
+  void drawStatistics(const char *, const ROIStatistics *, int, int);
+
+public:
+
+  /// Pointer to the registration viewer
+  RView *_v;
+
+  /// Constructor
+  Fl_ROIStatisticsWindow(int, int, int, int, const char *, RView *);
+
+  /// Destructor
+  ~Fl_ROIStatisticsWindow();
+
+  /// Default draw function
+  void draw();
+
 };
 
 #endif
@@ -556,8 +556,20 @@ void Fl_RViewUI::cb_fitLandmarks(Fl_Button *, void*)
 
 void Fl_RViewUI::cb_viewROI(Fl_Button* o, void*)
 {
-  if (o->value() == 0) rview->DisplayROIOff();
-  if (o->value() == 1) rview->DisplayROIOn();
+  if (o->value() == 0) {
+    rview->DisplayROIOff();
+    if (rviewUI->_roiStatisticsWindow != NULL) rviewUI->_roiStatisticsWindow->hide();
+  }
+  if (o->value() == 1) {
+    rview->DisplayROIOn();
+    if (rviewUI->_roiStatisticsWindow == NULL) {
+      rviewUI->_roiStatisticsWindow = new Fl_ROIStatisticsWindow(100, 100, 400, 300, "ROI statistics", rview);
+      Fl_Group::current()->resizable(rviewUI->_roiStatisticsWindow);
+      rviewUI->_roiStatisticsWindow->color(FL_GRAY);
+      rviewUI->_roiStatisticsWindow->end();
+    }
+    rviewUI->_roiStatisticsWindow->show();
+  }
   rview->Update();
   viewer->redraw();
 }
@@ -674,6 +686,7 @@ void Fl_RViewUI::UpdateObjectControlWindow()
   rviewUI->viewLandmarks->value(rview->GetDisplayLandmarks());
   rviewUI->refineTags->value(rview->GetTrackTAG());
   rviewUI->viewTagGrid->value(rview->GetViewTAG());
+  if ((rviewUI->_roiStatisticsWindow != NULL) && (rviewUI->_roiStatisticsWindow->shown())) rviewUI->_roiStatisticsWindow->redraw();
 #ifdef HAS_VTK
   rviewUI->viewObjectMovie->value(rview->GetObjectMovie());
   rviewUI->warpObject->value(rview->GetDisplayObjectWarp());
@@ -682,6 +695,7 @@ void Fl_RViewUI::UpdateObjectControlWindow()
 
 void Fl_RViewUI::InitializeObjectControlWindow()
 {
+  _roiStatisticsWindow = NULL;
   {
     // Create target landmark controls
     Fl_Group* o = new Fl_Group(0, 30, 400, 235, "Target landmarks");
@@ -30,6 +30,9 @@ Fl_Multi_Browser *sourceLandmarkBrowser;
 /// Widget for ROI
 Fl_Button *viewROI;
 
+/// Window for displaying statistics of ROI
+Fl_ROIStatisticsWindow *_roiStatisticsWindow;
+
 /// Callbacks for landmarks and objects
 static void cb_viewROI(Fl_Button*, void*);
 static void cb_trackTAG(Fl_Button*, void*);
@@ -179,6 +179,9 @@ void Fl_RViewUI::cb_startRegistration(Fl_Button* o, void* v)
     registration->SetCallback2(registration_cb2);
     registration->Run();
 
+    // Transformation has been modified in place
+    rview->SourceUpdateOn();
+
     // Update transformation browser in case things have changed
     for (i = 0; i <= rview->NumberOfDeformationLevels(); i++) {
       rview->GetTransformationText(i, buffer);
@@ -155,13 +155,12 @@ void Fl_RViewUI::cb_addSegment(Fl_Button *, void *)
 {
   int i;
   char buffer[256];
+  SegmentTable *table = rview->GetSegmentTable();
 
-  // Compute default id
-  for (i = 0; i <= rview->GetSegmentTable()->Size(); i++) {
-    if (rview->GetSegmentTable()->IsValid(i) != true) {
-      rviewUI->_id = i;
-      break;
-    }
+  // Compute default id (smallest unused non-negative label)
+  rviewUI->_id = 0;
+  for (i = 0; i < table->NumberOfSegments(); i++) {
+    if (table->GetSegmentId(i) == rviewUI->_id) rviewUI->_id++;
   }
 
   // Put default id
@@ -254,12 +253,11 @@ void Fl_RViewUI::cb_displaySegmentContours(Fl_Check_Button *o, void *)
 
 void Fl_RViewUI::cb_selectAll(Fl_Check_Button *, void *)
 {
-  //if (o->value() == 1){
-  for (int j=0; j<100; j++)
-    if ( rview->GetSegmentTable()->IsValid(j) == true) {
-      rview->GetSegmentTable()->SetVisibility(j,1);
-    }
-  //}
+  SegmentTable *table = rview->GetSegmentTable();
+
+  for (int j = 0; j < table->NumberOfSegments(); j++) {
+    table->SetVisibility(table->GetSegmentId(j), 1);
+  }
   // Update
   rview->SegmentationUpdateOn();
   rview->Update();
@@ -269,10 +267,10 @@ void Fl_RViewUI::cb_selectAll(Fl_Check_Button *, void *)
 
 void Fl_RViewUI::cb_deselectAll(Fl_Check_Button *, void *)
 {
-  for (int j=0; j<100; j++) {
-    if (rview->GetSegmentTable()->IsValid(j) == true) {
-      rview->GetSegmentTable()->SetVisibility(j, 0);
-    }
+  SegmentTable *table = rview->GetSegmentTable();
+
+  for (int j = 0; j < table->NumberOfSegments(); j++) {
+    table->SetVisibility(table->GetSegmentId(j), 0);
   }
   // Update
   rview->SegmentationUpdateOn();
@@ -423,18 +421,18 @@ void Fl_RViewUI::ShowSegmentationControlWindow()
 
 void Fl_RViewUI::UpdateSegmentationBrowser()
 {
-  int i;
+  int i, id;
+  char buffer[256];
+  SegmentTable *table = rview->GetSegmentTable();
 
   // Clear browser
   rviewUI->segmentObjectBrowser->clear();
 
   // Add labels
-  for (i = 0; i <= rview->GetSegmentTable()->Size(); i++) {
-    if (rview->GetSegmentTable()->IsValid(i) == true) {
-      char buffer[256];
-      sprintf(buffer, "%d \t %s", i, rview->GetSegmentTable()->GetLabel(i));
-      rviewUI->segmentObjectBrowser->add(buffer);
-    }
+  for (i = 0; i < table->NumberOfSegments(); i++) {
+    id = table->GetSegmentId(i);
+    snprintf(buffer, sizeof(buffer), "%d \t %s", id, table->GetLabel(id));
+    rviewUI->segmentObjectBrowser->add(buffer);
   }
 }
 
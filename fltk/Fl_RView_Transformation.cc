@@ -26,6 +26,28 @@ extern Fl_RViewUI  *rviewUI;
 extern Fl_RView    *viewer;
 extern RView    *rview;
 
+/// Compose all transformations of the browser in order if requested, the selected one is the source transformation
+static void ComposeTransformations()
+{
+  int i, n;
+  char **names;
+
+  if ((rviewUI->transformCompose->value() == 0) || (rviewUI->transformationBrowser->value() == 0)) {
+    if (rview->GetTransformationChainLength() > 0) rview->ClearTransformationChain();
+    return;
+  }
+  n = rviewUI->transformationBrowser->size();
+  names = new char *[n];
+  for (i = 0; i < n; i++) {
+    names[i] = strdup(rviewUI->transformationBrowser->text(i + 1));
+  }
+  rview->ReadTransformationChain(n, names, rviewUI->transformationBrowser->value() - 1);
+  for (i = 0; i < n; i++) {
+    free(names[i]);
+  }
+  delete[] names;
+}
+
 void Fl_RViewUI::AddTransformation(char *filename)
 {
   int i;
@@ -38,6 +60,7 @@ void Fl_RViewUI::AddTransformation(char *filename)
   rview->ReadTransformation(buffer);
   rviewUI->info_trans_filename->value(buffer);
   free(buffer);
+  ComposeTransformations();
 
   // Update transformation valuator
   mirtk::Transformation *transform = rview->GetTransformation();
@@ -64,6 +87,7 @@ void Fl_RViewUI::cb_loadTransformation(Fl_Button *, void *)
     rviewUI->transformationBrowser->deselect();
     rviewUI->transformationBrowser->select(rviewUI->transformationBrowser->size());
     rviewUI->info_trans_filename->value(filename);
+    ComposeTransformations();
     // Update
     rview->Update();
     viewer->redraw();
@@ -123,6 +147,7 @@ void Fl_RViewUI::cb_browseTransformation(Fl_Browser* o, void*)
       free(buffer);
     }
   }
+  ComposeTransformations();
 
   // Update
   rview->Update();
@@ -150,6 +175,7 @@ void Fl_RViewUI::cb_deleteTransformation(Fl_Button* o, void*)
     }
   }
   o->clear();
+  ComposeTransformations();
 
   // Update
   rview->Update();
@@ -230,6 +256,16 @@ void Fl_RViewUI::cb_invertTransformation(Fl_Button* o, void*)
   viewer->redraw();
 }
 
+void Fl_RViewUI::cb_composeTransformation(Fl_Button*, void*)
+{
+  ComposeTransformations();
+
+  // Update
+  rview->Update();
+  rviewUI->update();
+  viewer->redraw();
+}
+
 void Fl_RViewUI::cb_moveupTransformation(Fl_Button* o, void*)
 {
   int n;
@@ -247,8 +283,10 @@ void Fl_RViewUI::cb_moveupTransformation(Fl_Button* o, void*)
     }
   }
   o->clear();
+  ComposeTransformations();
 
   // Update
+  rview->Update();
   rviewUI->update();
   viewer->redraw();
 }
@@ -270,8 +308,10 @@ void Fl_RViewUI::cb_movedownTransformation(Fl_Button* o, void*)
     }
   }
   o->clear();
+  ComposeTransformations();
 
   // Update
+  rview->Update();
   rviewUI->update();
   viewer->redraw();
 }
@@ -384,6 +424,24 @@ void Fl_RViewUI::cb_cacheDisplacements(Fl_Button* o, void*)
   viewer->redraw();
 }
 
+void Fl_RViewUI::cb_precomputeDisplacements(Fl_Button* o, void*)
+{
+  if (o->value() == 0) rview->PrecomputeDisplacementsOff();
+  if (o->value() == 1) rview->PrecomputeDisplacementsOn();
+  rview->Update();
+  viewer->redraw();
+  rviewUI->update();
+}
+
+void Fl_RViewUI::cb_precompute(void*)
+{
+  // Compute one tile at a time so that events are handled in between
+  if (rview->PrecomputeDisplacements() != true) {
+    Fl::remove_idle(cb_precompute);
+  }
+  rviewUI->precomputeProgress->value(100 * rview->GetDisplacementCacheProgress());
+}
+
 void Fl_RViewUI::UpdateTransformationControlWindow()
 {
   int j;
@@ -411,6 +469,13 @@ void Fl_RViewUI::UpdateTransformationControlWindow()
   rviewUI->viewDeformationGridResolution->value(rview->GetDisplayDeformationGridResolution());
   rviewUI->deformationBlending->value(rview->GetDisplayDeformationBlending());
   rviewUI->cacheDisplacements->value(rview->GetCacheDisplacements());
+  rviewUI->precomputeDisplacements->value(rview->GetPrecomputeDisplacements());
+  rviewUI->precomputeProgress->value(100 * rview->GetDisplacementCacheProgress());
+
+  // Resume precomputation which may have been invalidated by changes of the transformation
+  if ((rview->GetPrecomputeDisplacements() == true) && (Fl::has_idle(cb_precompute) == 0)) {
+    Fl::add_idle(cb_precompute);
+  }
 
   // Get transformation
   mirtk::Transformation *transform = rview->GetTransformation();
@@ -469,9 +534,12 @@ void Fl_RViewUI::InitializeTransformationControlWindow()
       transformInvert = new Fl_Check_Button(200, 320, 170, 20, "  Invert transformation");
       transformInvert->callback((Fl_Callback*)cb_invertTransformation);
 
-      info_trans_filename = new Fl_Output(150, 350, 230, 20, "Transform filename = ");
+      transformCompose = new Fl_Check_Button(20, 345, 170, 20, "  Compose all transformations");
+      transformCompose->callback((Fl_Callback*)cb_composeTransformation);
+
+      info_trans_filename = new Fl_Output(150, 372, 230, 20, "Transform filename = ");
       info_trans_filename->box(FL_FLAT_BOX);
-      info_trans_details = new Fl_Hold_Browser(150, 380, 230, 70, "Transform details    = ");
+      info_trans_details = new Fl_Hold_Browser(150, 398, 230, 52, "Transform details    = ");
       info_trans_details->align(FL_ALIGN_LEFT);
     }
     o->end(); // End of transformation controls
@@ -502,6 +570,17 @@ void Fl_RViewUI::InitializeTransformationControlWindow()
       Fl_Check_Button *o  = cacheDisplacements = new Fl_Check_Button(20, 540, 120, 20, "Cache displacements");
       o->callback((Fl_Callback*)cb_cacheDisplacements);
     }
+    {
+      Fl_Check_Button *o  = precomputeDisplacements = new Fl_Check_Button(210, 540, 90, 20, "Precompute");
+      o->callback((Fl_Callback*)cb_precomputeDisplacements);
+    }
+    {
+      Fl_Progress *o = precomputeProgress = new Fl_Progress(310, 542, 80, 16);
+      o->minimum(0);
+      o->maximum(100);
+      o->value(0);
+      o->selection_color(FL_BLUE);
+    }
     {
       Fl_Value_Slider* o = viewDeformationGridResolution = new Fl_Value_Slider(10, 590, 380, 20, "Deformation field resolution");
       o->step(1);
@@ -31,6 +31,9 @@ Fl_Button *transformApply;
 /// Widget for inverting transformation
 Fl_Button *transformInvert;
 
+/// Widget for composing all transformations of the browser
+Fl_Button *transformCompose;
+
 /// Widget for display control of deformation points
 Fl_Check_Button *viewDeformationPoints;
 
@@ -46,6 +49,12 @@ Fl_Check_Button *viewDeformationTotal;
 /// Widget for control of displacement caching
 Fl_Check_Button *cacheDisplacements;
 
+/// Widget for control of background precomputation of cached displacements
+Fl_Check_Button *precomputeDisplacements;
+
+/// Widget for progress of background precomputation
+Fl_Progress *precomputeProgress;
+
 /// Widget for display control of maximum deformation value
 Fl_Value_Slider *deformationMax;
 
@@ -69,6 +78,7 @@ static void cb_browseTransformation(Fl_Browser*, void*);
 static void cb_deleteTransformation(Fl_Button*, void*);
 static void cb_applyTransformation(Fl_Button*, void*);
 static void cb_invertTransformation(Fl_Button*, void*);
+static void cb_composeTransformation(Fl_Button*, void*);
 static void cb_moveupTransformation(Fl_Button*, void*);
 static void cb_movedownTransformation(Fl_Button*, void*);
 static void cb_editTransformation(Fl_Button*, void*);
@@ -82,6 +92,8 @@ static void cb_viewDeformationPoints(Fl_Button*, void*);
 static void cb_viewDeformationArrows(Fl_Button*, void*);
 static void cb_viewDeformationTotal(Fl_Button*, void*);
 static void cb_cacheDisplacements(Fl_Button*, void*);
+static void cb_precomputeDisplacements(Fl_Button*, void*);
+static void cb_precompute(void*);
 static void cb_loadTransformation(Fl_Button*, void*);
 static void cb_saveTransformation(Fl_Button*, void*);
 static void cb_movieTransformation(Fl_Button*, void*);
@@ -60,6 +60,8 @@ void usage()
 "\t<-smax value>                    Max. source intensity\n"
 "\t<-sub_min value>                 Min. subtraction intensity\n"
 "\t<-sub_max value>                 Max. subtraction intensity\n"
+"\t<-percentiles min max>           Percentiles of default display range\n"
+"\t                                   (default 0.5 99.5)\n"
 "\t<-view_target>                   View target (default)\n"
 "\t<-view_source>                   View source\n"
 "\t<-mix>                           Mixed viewport (checkerboard)\n"
@@ -69,6 +71,13 @@ void usage()
 "\t<-diff>                          Subtraction view\n"
 "\t<-tcontour>                      Switch on target contours (see -tmin)\n"
 "\t<-scontour>                      Switch on source contours (see -smin)\n"
+"\t<-isolines n>                    Number of contour levels (default 1)\n"
+"\t<-float>                         Reslice and colour map intensities in\n"
+"\t                                   floating point\n"
+"\t<-cache_dir        directory>    Keep cached displacements in directory\n"
+"\t                                   across sessions\n"
+"\t<-cache_size       size>         Size limit of cache directory in MB\n"
+"\t                                   (default 2048)\n"
 "\t<-seg              file.nii.gz>  Labelled segmentation image\n"
 "\t<-lut              file.seg>     Colour lookup table for labelled\n"
 "\t                                   segmentation\n"
@@ -352,6 +361,16 @@ int main(int argc, char **argv)
       argv++;
       ok = true;
     }
+    if ((ok == false) && (strcmp(argv[1], "-percentiles") == 0)) {
+      argc--;
+      argv++;
+      rview->SetAutoWindowPercentiles(atof(argv[1]), atof(argv[2]));
+      argc--;
+      argv++;
+      argc--;
+      argv++;
+      ok = true;
+    }
     if ((ok == false) && (strcmp(argv[1], "-tmin") == 0)) {
       argc--;
       argv++;
@@ -518,6 +537,37 @@ int main(int argc, char **argv)
       ok = true;
     }
 
+    if ((ok == false) && (strcmp(argv[1], "-float") == 0)){
+      argv++;
+      argc--;
+      rview->FloatDisplayOn();
+      ok = true;
+    }
+    if ((ok == false) && (strcmp(argv[1], "-cache_dir") == 0)){
+      argv++;
+      argc--;
+      rview->SetDisplacementCacheDirectory(argv[1]);
+      argv++;
+      argc--;
+      ok = true;
+    }
+    if ((ok == false) && (strcmp(argv[1], "-cache_size") == 0)){
+      argv++;
+      argc--;
+      rview->SetDisplacementCacheSize(atoi(argv[1]));
+      argv++;
+      argc--;
+      ok = true;
+    }
+    if ((ok == false) && (strcmp(argv[1], "-isolines") == 0)){
+      argv++;
+      argc--;
+      rview->SetIsolineLevels(atoi(argv[1]));
+      argv++;
+      argc--;
+      ok = true;
+    }
+
     if ((ok == false) && (strcmp(argv[1], "-tcolor") == 0)) {
       argc--;
       argv++;
@@ -0,0 +1,225 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#ifndef _DISPLACEMENTCACHE_H
+
+#define _DISPLACEMENTCACHE_H
+
+#include <mirtk/Image.h>
+#include <mirtk/Transformation.h>
+
+#include <vector>
+
+/// Number of voxel cells along each edge of a cache tile
+#define DISPLACEMENT_CACHE_TILE 32
+
+/// Default memory limit of the cached tiles (MB)
+#define DISPLACEMENT_CACHE_MEMORY 256
+
+/// Default size limit of the cache directory (MB)
+#define DISPLACEMENT_CACHE_DISK 2048
+
+/// Maximum number of frame pairs whose tiles are kept for playback
+#define DISPLACEMENT_CACHE_FRAMES 64
+
+/// Maximum number of fixed-point iterations of inverse displacements
+#define DISPLACEMENT_CACHE_INVERSE_ITERATIONS 20
+
+/// Inverse-consistency error at which fixed-point iterations stop (mm)
+#define DISPLACEMENT_CACHE_INVERSE_TOLERANCE 1e-3
+
+/// Class for displacements of a transformation cached lazily in tiles of a voxel grid
+class DisplacementCache
+{
+
+protected:
+
+  /// Transformations applied in order whose composed displacements are cached
+  std::vector<mirtk::Transformation *> _transformations;
+
+  /// Grid on which displacements are sampled
+  mirtk::ImageAttributes _attr;
+
+  /// Time of the transformed points and temporal origin of the current frame pair
+  double _t, _t0;
+
+  /// Whether displacements depend on time (otherwise all frames share a frame pair at time 0)
+  bool _timeVarying;
+
+  /// Times of each frame pair whose tiles are kept
+  std::vector<double> _frameT, _frameT0;
+
+  /// Time stamp of last use of each frame pair
+  std::vector<long> _frameUse;
+
+  /// Hash of each frame pair for the cache directory
+  std::vector<unsigned long long> _frameKey;
+
+  /// Current frame pair
+  int _frame;
+
+  /// Number of tiles of each frame pair
+  int _numberOfFrameTiles;
+
+  /// Tiles of a frame pair required since the current one was selected
+  std::vector<int> _workingSet;
+
+  /// Stamp of the selection in which each tile was added to the working set
+  std::vector<long> _workingUse;
+
+  /// Current selection stamp
+  long _workingStamp;
+
+  /// Version of the transformation parameters
+  int _version;
+
+  /// Whether displacements of the inverse transformation are cached
+  bool _inverse;
+
+  /// Sum and maximum of the inverse-consistency errors of the interpolated inverse at sampled cell centres (mm)
+  double _inverseErrorSum, _inverseErrorMax;
+
+  /// Number of cell centres of which inverse-consistency errors have been summed
+  long _inverseErrorCount;
+
+  /// Number of tiles along each axis
+  int _nx, _ny, _nz;
+
+  /// Displacements of each tile of each frame pair at its (TILE+1)^3 grid points (empty if not computed)
+  std::vector<std::vector<float> > _tiles;
+
+  /// Time stamp of last use of each tile
+  std::vector<long> _lastUse;
+
+  /// Current time stamp
+  long _clock;
+
+  /// Tiles required by the next update
+  std::vector<int> _required;
+
+  /// Number of computed tiles
+  int _numberOfTiles;
+
+  /// Maximum number of computed tiles
+  int _maxNumberOfTiles;
+
+  /// Directory in which tiles are kept across sessions (NULL if none)
+  char *_directory;
+
+  /// Size and size limit of the cache directory (bytes)
+  double _diskSize, _diskLimit;
+
+  /// Hash of the transformation parameters and grid
+  unsigned long long _key;
+
+  /// Find frame pair of the given times, adding one or reusing the least recently used one if missing
+  int FindFrame(double, double);
+
+  /// Make the frame pair of the given times the current one
+  void SelectFrame(double, double);
+
+  /// Compute displacements of a tile
+  void ComputeTile(int);
+
+  /// File name of a tile in the cache directory (false if it does not fit into the buffer of given size)
+  bool TileFileName(int, char *, int) const;
+
+  /// Read a tile from the cache directory (false if it has not been stored)
+  bool ReadTile(int);
+
+  /// Store a tile in the cache directory
+  void WriteTile(int);
+
+  /// Delete least recently used files until the cache directory is below its size limit
+  void TrimDirectory();
+
+  /// Discard least recently used tiles which are not required until at most the given number is left
+  void Evict(int);
+
+public:
+
+  /// Constructor
+  DisplacementCache();
+
+  /// Destructor
+  ~DisplacementCache();
+
+  /// Discard all tiles
+  void Clear();
+
+  /// Whether the displacements of a transformation depend on time
+  static bool IsTimeVarying(mirtk::Transformation *);
+
+  /// Cache displacements of a transformation version on a grid at a time (keeps tiles if nothing but the time changed)
+  void Initialize(mirtk::Transformation *, int, const mirtk::ImageAttributes &, double, double);
+
+  /// Cache composed displacements of a chain of transformations applied in order
+  void Initialize(const std::vector<mirtk::Transformation *> &, int, const mirtk::ImageAttributes &, double, double);
+
+  /// Whether no transformation is cached
+  bool IsEmpty() const;
+
+  /// Set memory limit of the cached tiles (MB)
+  void SetMemoryLimit(int);
+
+  /// Set directory in which tiles are kept across sessions (NULL to disable)
+  void SetDirectory(const char *);
+
+  /// Set size limit of the cache directory (MB)
+  void SetDiskLimit(int);
+
+  /// Get number of computed tiles
+  int GetNumberOfTiles() const;
+
+  /// Mark tile which contains a world point as required by the next Update
+  void Require(double, double, double);
+
+  /// Compute required tiles which are missing
+  void Update();
+
+  /// Displacement at a world point, interpolated if its tile has been computed
+  void Displacement(double &, double &, double &) const;
+
+  /// Cache displacements of the inverse transformation (discards all tiles if changed)
+  void SetInverse(bool);
+
+  /// Transform a world point, computing its tile first if it is missing (inverses of points in missing tiles are evaluated directly)
+  void Transform(double &, double &, double &);
+
+  /// Mean and maximum inverse-consistency error of the computed inverse displacements (false if none has been sampled)
+  bool GetInverseError(double &, double &) const;
+
+  /// Compute the missing tile closest to a world point within the memory limit (false if none is left)
+  bool Precompute(double, double, double);
+
+  /// Compute a missing tile of another frame pair which the current planes require (false if none is left)
+  bool PrecomputeFrame(double, double);
+
+  /// Number of frame pairs whose tiles required by the current planes fit within the memory limit
+  int GetFrameCapacity() const;
+
+  /// Fraction of the tiles of the current frame pair within the memory limit which have been computed
+  double GetProgress() const;
+
+};
+
+inline bool DisplacementCache::IsEmpty() const
+{
+  return _transformations.empty();
+}
+
+inline int DisplacementCache::GetNumberOfTiles() const
+{
+  return _numberOfTiles;
+}
+
+#endif
@@ -16,6 +16,8 @@
 
 #include <RView.h>
 
+#include <map>
+
 #define HISTOGRAM_BINS 256
 
 class HistogramWindow
@@ -31,8 +33,14 @@ protected:
   /// Global histogram for entire image
   mirtk::Histogram1D<int> _globalHistogram;
 
-  /// Global histogram for single segmentation
-  mirtk::Histogram1D<int> _localHistogram[SHRT_MAX+1];
+  /// Global histogram for each active segmentation label
+  std::map<int, mirtk::Histogram1D<int> > _localHistogram;
+
+  /// Whether the histograms have been computed
+  bool _valid;
+
+  /// Whether the segmentation can be sampled on the target grid
+  bool SegmentationMatchesTarget();
 
 public:
 
@@ -42,13 +50,11 @@ public:
   /// Destructor
   virtual ~HistogramWindow() {};
 
-  /// Compute histograms for everything
+  /// Compute histograms for everything (single pass over the target)
   void CalculateHistograms();
 
-protected:
-
-  /// Compute histogram for single segmentation
-  void CalculateHistogram(int);
+  /// Update label histograms for changed segmentation voxels only
+  void UpdateHistograms(const std::vector<LabelChange> &);
 };
 
 #endif
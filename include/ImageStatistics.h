@@ -0,0 +1,109 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#ifndef _IMAGESTATISTICS_H
+
+#define _IMAGESTATISTICS_H
+
+#include <mirtk/Image.h>
+
+#include <vector>
+
+/// Number of bins of the intensity histogram of images with floating point or 32-bit voxels
+#define IMAGE_STATISTICS_BINS 4096
+
+/// Class for intensity statistics of an image which are computed once on load
+class ImageStatistics
+{
+
+protected:
+
+  /// Minimum intensity
+  double _min;
+
+  /// Maximum intensity
+  double _max;
+
+  /// Intensity of the lower bound of the first bin
+  double _binMin;
+
+  /// Width of a bin (1 for images with 8 or 16-bit integer voxels)
+  double _binWidth;
+
+  /// Number of voxels in each bin
+  std::vector<int> _bins;
+
+  /// Lower bound of the first bin of the fine histogram
+  double _fineMin;
+
+  /// Width of a bin of the fine histogram
+  double _fineWidth;
+
+  /// Number of voxels in each bin of the fine histogram (empty if not needed)
+  std::vector<int> _fineBins;
+
+  /// Number of voxels below and inside the range of the fine histogram
+  int _fineBelow, _fineCount;
+
+  /// Number of voxels in the histogram (voxels which are not finite are ignored)
+  int _count;
+
+  /// Histogram of every voxel value of images with 8 or 16-bit integer voxels
+  template <class VoxelType> void CountIntensities(const VoxelType *, int);
+
+  /// Range and histograms of images with other voxel types
+  template <class VoxelType> void BinIntensities(const VoxelType *, int);
+
+public:
+
+  /// Constructor
+  ImageStatistics();
+
+  /// Discard statistics
+  void Clear();
+
+  /// Compute min, max and histogram of all voxels in parallel
+  void Compute(mirtk::Image *);
+
+  /// Whether statistics have been computed
+  bool IsEmpty() const;
+
+  /// Minimum intensity
+  double GetMin() const;
+
+  /// Maximum intensity
+  double GetMax() const;
+
+  /// Intensity below which the given percentage (0..100) of voxels lies
+  double Percentile(double) const;
+
+  /// Intensity range covering the given percentiles of voxels
+  void GetPercentileRange(double, double, double &, double &) const;
+
+};
+
+inline bool ImageStatistics::IsEmpty() const
+{
+  return (_count == 0);
+}
+
+inline double ImageStatistics::GetMin() const
+{
+  return _min;
+}
+
+inline double ImageStatistics::GetMax() const
+{
+  return _max;
+}
+
+#endif
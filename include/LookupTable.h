@@ -108,6 +108,11 @@ public:
   /// Get color for given image value
   ColorRGBA &operator ()(int);
 
+  /// Map float intensities onto colors analytically (no quantization). The
+  /// arguments are the intensities of the table domain (0..10000) and of the
+  /// display range.
+  void Map(const float *, int, double, double, double, double, ColorRGBA *);
+
   /// Get minimum display intensity
   int  GetMinDisplayIntensity();
 
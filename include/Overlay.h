@@ -0,0 +1,118 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#ifndef _OVERLAY_H
+
+#define _OVERLAY_H
+
+#include <vector>
+
+/// Maximum number of values in the key of an overlay
+#define MAX_OVERLAY_KEY 16
+
+/// Class for retained overlay geometry which is rebuilt only if its key changes
+class Overlay
+{
+
+protected:
+
+  /// OpenGL primitive type (GL_LINES, GL_POINTS or GL_TRIANGLES)
+  unsigned int _mode;
+
+  /// Values of the inputs from which the geometry was built
+  double _key[MAX_OVERLAY_KEY];
+
+  /// Number of values in key
+  int _keySize;
+
+  /// Flag whether the geometry is valid
+  bool _valid;
+
+  /// Vertex coordinates (x, y) relative to the viewer
+  std::vector<float> _vertices;
+
+  /// Vertex colours (r, g, b)
+  std::vector<unsigned char> _colors;
+
+  /// Colour of subsequently added vertices
+  unsigned char _r, _g, _b;
+
+public:
+
+  /// Constructor
+  Overlay();
+
+  /// Returns whether the geometry was built from the given key
+  bool IsValid(int, const double *) const;
+
+  /// Discard geometry and start a new one for given primitive type and key
+  void Begin(unsigned int, int, const double *);
+
+  /// Set colour of subsequently added vertices
+  void SetColor(unsigned char, unsigned char, unsigned char);
+
+  /// Add vertex
+  void AddVertex(float, float);
+
+  /// Add vertices given as array of (x, y) coordinates
+  void AddVertices(int, const float *);
+
+  /// Discard geometry
+  void Invalidate();
+
+  /// Number of vertices
+  int Size() const;
+
+  /// Draw geometry with a single call at the given screen offset
+  void Draw(float, float) const;
+
+};
+
+inline void Overlay::SetColor(unsigned char r, unsigned char g, unsigned char b)
+{
+  _r = r;
+  _g = g;
+  _b = b;
+}
+
+inline void Overlay::AddVertex(float x, float y)
+{
+  _vertices.push_back(x);
+  _vertices.push_back(y);
+  _colors.push_back(_r);
+  _colors.push_back(_g);
+  _colors.push_back(_b);
+}
+
+inline void Overlay::AddVertices(int n, const float *xy)
+{
+  int i;
+
+  _vertices.insert(_vertices.end(), xy, xy + 2 * n);
+  for (i = 0; i < n; i++) {
+    _colors.push_back(_r);
+    _colors.push_back(_g);
+    _colors.push_back(_b);
+  }
+}
+
+inline void Overlay::Invalidate()
+{
+  _valid = false;
+}
+
+inline int Overlay::Size() const
+{
+  return _vertices.size() / 2;
+}
+
+#endif
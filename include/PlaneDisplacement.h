@@ -0,0 +1,104 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#ifndef _PLANEDISPLACEMENT_H
+
+#define _PLANEDISPLACEMENT_H
+
+#include <mirtk/Image.h>
+#include <mirtk/Transformation.h>
+#include <mirtk/HomogeneousTransformation.h>
+#include <mirtk/FreeFormTransformation.h>
+
+#include <DisplacementCache.h>
+
+#include <vector>
+
+/// Class for the displacements of a transformation at all pixels of a viewer plane
+class PlaneDisplacement
+{
+
+protected:
+
+  /// Number of pixels along each axis of the plane
+  int _x, _y;
+
+  /// Displacement of each pixel (world coordinates, stored row by row)
+  std::vector<double> _dx, _dy, _dz;
+
+  /// Add displacement of a cubic B-spline FFD, evaluated separably along the lattice axes
+  bool AddFFD(mirtk::FreeFormTransformation *, mirtk::Image *);
+
+  /// Add displacement of a linear transformation or of its inverse, which varies linearly across the plane
+  void AddLinear(const mirtk::Transformation *, mirtk::Image *, bool);
+
+public:
+
+  /// Constructor
+  PlaneDisplacement();
+
+  /// Whether the displacements of a transformation can be computed
+  static bool IsSupported(mirtk::Transformation *);
+
+  /// Compute displacements at the pixels of the plane of an image (false if not separable)
+  bool Compute(mirtk::Transformation *, mirtk::Image *);
+
+  /// Compute displacements of a linear transformation or of its inverse at the pixels of the plane of an image
+  void Compute(mirtk::HomogeneousTransformation *, mirtk::Image *, bool);
+
+  /// Compute displacements at the pixels of the plane of an image from the tiles of a cache,
+  /// computing its missing tiles first if requested
+  void Compute(DisplacementCache *, mirtk::Image *, bool);
+
+  /// Number of pixels along the x-axis of the plane
+  int GetX() const;
+
+  /// Number of pixels along the y-axis of the plane
+  int GetY() const;
+
+  /// Displacements along the world x-axis
+  const double *GetDX() const;
+
+  /// Displacements along the world y-axis
+  const double *GetDY() const;
+
+  /// Displacements along the world z-axis
+  const double *GetDZ() const;
+
+};
+
+inline int PlaneDisplacement::GetX() const
+{
+  return _x;
+}
+
+inline int PlaneDisplacement::GetY() const
+{
+  return _y;
+}
+
+inline const double *PlaneDisplacement::GetDX() const
+{
+  return &_dx[0];
+}
+
+inline const double *PlaneDisplacement::GetDY() const
+{
+  return &_dy[0];
+}
+
+inline const double *PlaneDisplacement::GetDZ() const
+{
+  return &_dz[0];
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#ifndef _ROISTATISTICS_H
+
+#define _ROISTATISTICS_H
+
+#include <mirtk/Image.h>
+
+#include <vector>
+
+/// Number of bins of the histogram of a region of interest
+#define ROI_STATISTICS_BINS 64
+
+/// Class for intensity statistics of a box shaped region of interest of one frame
+class ROIStatistics
+{
+
+protected:
+
+  /// Image for which the tables have been built
+  mirtk::Image *_image;
+
+  /// Frame for which the tables have been built
+  int _frame;
+
+  /// Image dimensions
+  int _x, _y, _z;
+
+  /// Value subtracted from voxels before summation to preserve precision
+  double _offset;
+
+  /// Summed-area tables of value and squared value with a leading zero plane in each dimension
+  std::vector<double> _sum, _sum2;
+
+  /// Histogram bin of each voxel (ROI_STATISTICS_BINS for voxels which are not finite)
+  std::vector<unsigned char> _bin;
+
+  /// Intensity of the lower bound of the first bin and width of a bin
+  double _binMin, _binWidth;
+
+  /// Region of interest of the current statistics (voxel indices, inclusive)
+  int _i1, _j1, _k1, _i2, _j2, _k2;
+  /// Number of finite voxels in the region of interest
+  /// Number of voxels in the region of interest
+  int _count;
+
+  /// Mean and standard deviation in the region of interest
+  double _mean, _sigma;
+
+  /// Histogram of the region of interest
+  std::vector<int> _histogram;
+
+  /// Build summed-area tables and bin indices of a frame
+  template <class VoxelType> void Integrate(const VoxelType *);
+
+  /// Sum of a table over a box
+  double BoxSum(const std::vector<double> &) const;
+
+public:
+
+  /// Constructor
+  ROIStatistics();
+
+  /// Discard tables and statistics
+  void Clear();
+
+  /// Build tables for a frame of an image unless they exist already
+  void Initialize(mirtk::Image *, int, double, double);
+
+  /// Whether tables have been built
+  bool IsEmpty() const;
+
+  /// Compute statistics of a box given by voxel indices (inclusive)
+  void Compute(int, int, int, int, int, int);
+
+  /// Number of voxels in the region of interest
+  int GetCount() const;
+
+  /// Mean intensity in the region of interest
+  double GetMean() const;
+
+  /// Standard deviation of the intensities in the region of interest
+  double GetSigma() const;
+
+  /// Intensity below which the given percentage (0..100) of voxels lies
+  double Percentile(double) const;
+
+  /// Histogram of the region of interest
+  const std::vector<int> &GetHistogram() const;
+
+  /// Intensity of the lower bound of a histogram bin
+  double BinToValue(int) const;
+
+};
+
+inline bool ROIStatistics::IsEmpty() const
+{
+  return (_image == NULL);
+}
+
+inline int ROIStatistics::GetCount() const
+{
+  return _count;
+}
+
+inline double ROIStatistics::GetMean() const
+{
+  return _mean;
+}
+
+inline double ROIStatistics::GetSigma() const
+{
+  return _sigma;
+}
+
+inline const std::vector<int> &ROIStatistics::GetHistogram() const
+{
+  return _histogram;
+}
+
+inline double ROIStatistics::BinToValue(int i) const
+{
+  return _binMin + i * _binWidth;
+}
+
+#endif
@@ -89,6 +89,8 @@ typedef enum { RegionGrowing2D, RegionGrowing3D } RegionGrowingMode;
 #endif
 
 #include <list>
+#include <vector>
+#include <cfloat>
 
 #ifdef HAS_VTK
 
@@ -103,11 +105,36 @@ typedef enum { RegionGrowing2D, RegionGrowing3D } RegionGrowingMode;
 
 #define MAX_SEGMENTS 256
 
+#define MAX_ISOLINES 8
+
 #define MAX_NUMBER_OF_OBJECTS 40
 
+/// Value of float reslice outputs outside the image domain
+#define FLOAT_PADDING_VALUE -FLT_MAX
+
+/// Label change of a single segmentation voxel
+struct LabelChange
+{
+  /// Index of voxel in segmentation image
+  int _index;
+
+  /// Label before the change
+  int _old;
+
+  /// Label after the change
+  int _new;
+};
+
 #include <SegmentTable.h>
 
 #include <LookupTable.h>
+#include <ImageStatistics.h>
+#include <ROIStatistics.h>
+#include <DisplacementCache.h>
+#include <PlaneDisplacement.h>
+#include <SplineCoefficientCache.h>
+#include <SincInterpolation.h>
+#include <Overlay.h>
 #include <Viewer.h>
 #include <RViewConfig.h>
 #include <HistogramWindow.h>
@@ -129,6 +156,9 @@ protected:
   /// Number of image viewers
   int _NoOfViewers;
 
+  /// Number of image viewers for which filters and images are allocated
+  int _NoOfViewersAllocated;
+
   /// Image viewer for target image
   Viewer **_viewer;
 
@@ -142,7 +172,7 @@ protected:
   mirtk::Image *_sourceImage;
 
   /// Segmentation image
-  mirtk::GreyImage *_segmentationImage;
+  mirtk::GenericImage<int> *_segmentationImage;
 
   /// Segment Table
   SegmentTable *_segmentTable;
@@ -168,12 +198,21 @@ protected:
   /// Transformation filter for reslicing of source image
   mirtk::ImageTransformation **_sourceTransformFilter;
 
-  /// Displacement field used to cache source transformation
-  mirtk::ImageTransformationCache _sourceTransformCache;
+  /// Displacements of source transformation cached in tiles
+  DisplacementCache _sourceDisplacementCache;
+
+  /// Inverse displacements of source transformation cached in tiles
+  DisplacementCache _sourceInverseCache;
+
+  /// Transformations composed in the order in which they are applied to target points (NULL stands for the source transformation)
+  std::vector<mirtk::Transformation *> _sourceTransformChain;
 
   /// Whether to cache displacements or not
   int _CacheDisplacements;
 
+  /// Whether to fill the displacement cache in the background
+  int _PrecomputeDisplacements;
+
   /// Transformation filter for reslicing of segmentation image
   mirtk::ImageTransformation **_segmentationTransformFilter;
 
@@ -186,8 +225,17 @@ protected:
   /// Source image
   mirtk::GreyImage **_sourceImageOutput;
 
+  /// Target image with float intensities (float display only)
+  mirtk::GenericImage<float> **_targetImageOutputFloat;
+
+  /// Source image with float intensities (float display only)
+  mirtk::GenericImage<float> **_sourceImageOutputFloat;
+
+  /// Flag whether images are resliced and color mapped with float precision
+  int _FloatDisplay;
+
   /// Segmentation image
-  mirtk::GreyImage **_segmentationImageOutput;
+  mirtk::GenericImage<int> **_segmentationImageOutput;
 
   /// Selection image
   mirtk::GreyImage **_selectionImageOutput;
@@ -201,6 +249,9 @@ protected:
   /// Contour
   VoxelContour _voxelContour;
 
+  /// Segmentation voxels changed by the last filled contour
+  std::vector<LabelChange> _labelChanges;
+
   /// Contour viewer
   int _contourViewer;
 
@@ -222,6 +273,15 @@ protected:
   /// Combined source and target images in OpenGL format
   Color **_drawable;
 
+  /// Number of pixels allocated for each drawable
+  int *_drawableSize;
+
+  /// Flags whether a drawable changed since it was last drawn
+  bool *_drawableModified;
+
+  /// Versions of the viewer outputs (incremented whenever they are resliced)
+  int _targetOutputVersion, _sourceOutputVersion, _segmentationOutputVersion;
+
   /// Color lookup table for target image
   LookupTable *_targetLookupTable;
 
@@ -237,6 +297,12 @@ protected:
   /// Source value range
   double _sourceMin, _sourceMax;
 
+  /// Target values mapped onto 0..10000 of the lookup table
+  double _targetDomainMin, _targetDomainMax;
+
+  /// Source values mapped onto 0..10000 of the lookup table
+  double _sourceDomainMin, _sourceDomainMax;
+
   /// Subtraction value range
   double _subtractionMin, _subtractionMax;
 
@@ -249,12 +315,42 @@ protected:
   /// Subtraction display value range
   double _subtractionDisplayMin, _subtractionDisplayMax;
 
+  /// Intensity statistics of target image (computed on load)
+  ImageStatistics _targetStatistics;
+
+  /// Intensity statistics of source image (computed on load)
+  ImageStatistics _sourceStatistics;
+
+  /// Cubic B-spline coefficients of the target frames
+  SplineCoefficientCache _targetCoefficients;
+
+  /// Cubic B-spline coefficients of the source frames
+  SplineCoefficientCache _sourceCoefficients;
+
+  /// Tabulated windowed sinc interpolation of the target frame
+  SincInterpolation _targetSinc;
+
+  /// Tabulated windowed sinc interpolation of the source frame
+  SincInterpolation _sourceSinc;
+
+  /// Percentiles (0..100) of intensities used as default display range
+  double _AutoWindowMin, _AutoWindowMax;
+
+  /// Intensity statistics of target image in ROI
+  ROIStatistics _targetROIStatistics;
+
+  /// Intensity statistics of source image in ROI
+  ROIStatistics _sourceROIStatistics;
+
   /// Target frame
   int _targetFrame;
 
   /// Source frame
   int _sourceFrame;
 
+  /// Displacements of the source transformation at the pixels of a viewer
+  PlaneDisplacement _sourcePlaneDisplacement;
+
   /// Flag to indicate whether target image must be updated
   int _targetUpdate;
 
@@ -310,6 +406,9 @@ protected:
   /// Flag whether transformation for reslicing of source image should be inverted
   bool _sourceTransformInvert;
 
+  /// Version of source transformation (incremented whenever it may have been modified)
+  int _sourceTransformVersion;
+
   /// Display viewing mix in shutter viewing mode
   double _viewMix;
 
@@ -349,6 +448,9 @@ protected:
   /// Flag for line thickness
   double _LineThickness;
 
+  /// Number of iso-levels (from min. towards max. display intensity)
+  int _IsolineLevels;
+
   /// Flag for spedd
   double _Speed;
 
@@ -421,6 +523,18 @@ protected:
   /// Current viewer in which the mouse is
   int _mouseViewer;
 
+  /// Cursor position and time parameters of the cached info transformations
+  double _infoX, _infoY, _infoZ, _infoTS, _infoTT;
+
+  /// Cursor position transformed into the source image (cached for info text)
+  mirtk::Point _infoSourcePoint;
+
+  /// Cursor position transformed into the segmentation (cached for info text)
+  mirtk::Point _infoSegmentationPoint;
+
+  /// Flags whether the cached info transformations are valid
+  bool _infoSourceValid, _infoSegmentationValid;
+
   /// Region growing mode
   RegionGrowingMode _regionGrowingMode;
 
@@ -435,6 +549,28 @@ protected:
   int _DisplayObjectGrid;
 #endif
 
+  /// Grow drawables if they are too small for the current viewer outputs
+  void AllocateDrawables();
+
+  /// Combine float target and source outputs of a viewer into its drawable
+  void UpdateDrawableFloat(int);
+
+  /// Reslice target of a viewer from cached B-spline coefficients or tabulated sinc weights (false if not applicable)
+  bool ResliceTarget(int);
+
+  /// Reslice source of a viewer using separable FFD evaluation, cached displacements,
+  /// cached B-spline coefficients or tabulated sinc weights (false if not applicable)
+  bool ResliceSource(int);
+
+  /// Set up displacement cache for the source transformation or its inverse (false if it is not cached)
+  bool InitializeDisplacementCache(bool = false);
+
+  /// Set target value and display range from cached intensity statistics
+  void AutoWindowTarget();
+
+  /// Set source value and display range from cached intensity statistics
+  void AutoWindowSource();
+
 public:
 
   /// Constructor
@@ -591,7 +727,16 @@ public:
   
   /// Get maximum subtraction intensity
   double GetSubtractionMax();
-  
+
+  /// Get intensity statistics of target image
+  const ImageStatistics *GetTargetStatistics();
+
+  /// Get intensity statistics of source image
+  const ImageStatistics *GetSourceStatistics();
+
+  /// Set percentiles (0..100) used as default display range and reapply them
+  void SetAutoWindowPercentiles(double, double);
+
   /// Set ROI to default parameters
   void ResetROI();
 
@@ -625,6 +770,12 @@ public:
   /// Get ROI
   void GetROI(double &, double &, double &, double &, double &, double &);
 
+  /// Get intensity statistics of target image in ROI
+  const ROIStatistics *GetTargetROIStatistics();
+
+  /// Get intensity statistics of source image in ROI (bounding box of the mapped ROI if the transformation is applied)
+  const ROIStatistics *GetSourceROIStatistics();
+
   /// Get an information string
   void GetInfoText(char *, char *, char *, char *, char *);
 
@@ -639,6 +790,12 @@ public:
 
   /// Get glLine thickness
   double GetLineThickness();
+
+  /// Set number of iso-levels of target and source isolines
+  void SetIsolineLevels(int);
+
+  /// Get number of iso-levels of target and source isolines
+  int GetIsolineLevels();
   
   /// Set speed
   void SetSpeed(double value);
@@ -682,6 +839,45 @@ public:
   /// Return displacements caching mode
   int GetCacheDisplacements();
 
+  /// Turn background precomputation of cached displacements on
+  void PrecomputeDisplacementsOn();
+
+  /// Turn background precomputation of cached displacements off
+  void PrecomputeDisplacementsOff();
+
+  /// Return background precomputation mode
+  int GetPrecomputeDisplacements();
+
+  /// Compute the cached displacements closest to the cursor (false if nothing is left to compute)
+  bool PrecomputeDisplacements();
+
+  /// Return fraction of the displacement cache which has been computed
+  double GetDisplacementCacheProgress();
+
+  /// Map a target point into the source using the source transformation or the composed chain
+  void Transform(double &, double &, double &);
+
+  /// Map a source point into the target using the cached inverse of the source transformation or the composed chain
+  void InverseTransform(double &, double &, double &);
+
+  /// Return mean and maximum inverse-consistency error of the cached inverse (false if nothing is cached)
+  bool GetInverseError(double &, double &);
+
+  /// Compose transformations read from files in order, the source transformation takes the given position
+  void ReadTransformationChain(int, char **, int);
+
+  /// Reslice through the source transformation alone again
+  void ClearTransformationChain();
+
+  /// Return number of composed transformations (0 if the source transformation is used alone)
+  int GetTransformationChainLength();
+
+  /// Set directory in which cached displacements are kept across sessions
+  void SetDisplacementCacheDirectory(const char *);
+
+  /// Set size limit of the displacement cache directory (MB)
+  void SetDisplacementCacheSize(int);
+
   /// Turn snap to grid on
   void SnapToGridOn();
 
@@ -966,6 +1162,9 @@ public:
   /// Get transformation invert flag for source image
   bool GetSourceTransformInvert();
 
+  /// Get version of source transformation
+  int GetSourceTransformVersion();
+
   /// Get a pointer to target image
   mirtk::Image *GetTarget();
 
@@ -1003,7 +1202,10 @@ public:
   mirtk::InterpolationMode GetSegmentationInterpolationMode();
 
   /// Get a pointer to segmentation image
-  mirtk::GreyImage *GetSegmentation();
+  mirtk::GenericImage<int> *GetSegmentation();
+
+  /// Get segmentation voxels changed by the last filled contour
+  const std::vector<LabelChange> &GetLabelChanges() const;
 
   /// Get a pointer to the lookup table of the segmentation image
   LookupTable *GetSegmentationLookupTable();
@@ -1020,6 +1222,15 @@ public:
   /// Gets the current display value
   int GetDisplaySegmentationLabels();
 
+  /// Turns on reslicing and color mapping with float precision
+  void FloatDisplayOn();
+
+  /// Turns off reslicing and color mapping with float precision
+  void FloatDisplayOff();
+
+  /// Gets whether images are displayed with float precision
+  int GetFloatDisplay();
+
   /// Turns on the segmentation drawing
   void SegmentationContoursOn();
 
@@ -1122,6 +1333,12 @@ public:
 inline void RView::SourceUpdateOn()
 {
   _sourceUpdate = true;
+  _sourceTransformVersion++;
+}
+
+inline int RView::GetSourceTransformVersion()
+{
+  return _sourceTransformVersion;
 }
 
 inline void RView::SegmentationUpdateOn()
@@ -1192,6 +1409,18 @@ inline double RView::GetLineThickness()
   return _LineThickness;
 }
 
+inline void RView::SetIsolineLevels(int value)
+{
+  if (value < 1) value = 1;
+  if (value > MAX_ISOLINES) value = MAX_ISOLINES;
+  _IsolineLevels = value;
+}
+
+inline int RView::GetIsolineLevels()
+{
+  return _IsolineLevels;
+}
+
 inline void RView::CacheDisplacementsOn()
 {
   _CacheDisplacements = true;
@@ -1209,6 +1438,42 @@ inline int RView::GetCacheDisplacements()
   return _CacheDisplacements;
 }
 
+inline void RView::PrecomputeDisplacementsOn()
+{
+  _PrecomputeDisplacements = true;
+}
+
+inline void RView::PrecomputeDisplacementsOff()
+{
+  _PrecomputeDisplacements = false;
+}
+
+inline int RView::GetPrecomputeDisplacements()
+{
+  return _PrecomputeDisplacements;
+}
+
+inline double RView::GetDisplacementCacheProgress()
+{
+  return _sourceDisplacementCache.GetProgress();
+}
+
+inline int RView::GetTransformationChainLength()
+{
+  return _sourceTransformChain.size();
+}
+
+inline void RView::SetDisplacementCacheDirectory(const char *directory)
+{
+  _sourceDisplacementCache.SetDirectory(directory);
+  _sourceUpdate = true;
+}
+
+inline void RView::SetDisplacementCacheSize(int size)
+{
+  _sourceDisplacementCache.SetDiskLimit(size);
+}
+
 inline void RView::SetSpeed(double value)
 {
   _Speed = value;
@@ -1792,11 +2057,16 @@ inline mirtk::Image *RView::GetSource()
   return _sourceImage;
 }
 
-inline mirtk::GreyImage *RView::GetSegmentation()
+inline mirtk::GenericImage<int> *RView::GetSegmentation()
 {
   return _segmentationImage;
 }
 
+inline const std::vector<LabelChange> &RView::GetLabelChanges() const
+{
+  return _labelChanges;
+}
+
 inline VoxelContour *RView::GetVoxelContour()
 {
   return &_voxelContour;
@@ -2024,6 +2294,21 @@ inline double RView::GetSubtractionMax()
   return _subtractionMax;
 }
 
+inline int RView::GetFloatDisplay()
+{
+  return _FloatDisplay;
+}
+
+inline const ImageStatistics *RView::GetTargetStatistics()
+{
+  return &_targetStatistics;
+}
+
+inline const ImageStatistics *RView::GetSourceStatistics()
+{
+  return &_sourceStatistics;
+}
+
 inline double RView::GetDisplayMinTarget()
 {
 	return _targetDisplayMin;
@@ -2037,13 +2322,13 @@ inline double RView::GetDisplayMaxTarget()
 inline void RView::SetDisplayMinTarget(double value)
 {
 	_targetDisplayMin = value;
-	_targetLookupTable->SetMinDisplayIntensity(round((value - _targetMin) * 10000.0 / (_targetMax - _targetMin)));
+	_targetLookupTable->SetMinDisplayIntensity(round((value - _targetDomainMin) * 10000.0 / (_targetDomainMax - _targetDomainMin)));
 }
 
 inline void RView::SetDisplayMaxTarget(double value)
 {
 	_targetDisplayMax = value;
-	_targetLookupTable->SetMaxDisplayIntensity(round((value - _targetMin) * 10000.0 / (_targetMax - _targetMin)));
+	_targetLookupTable->SetMaxDisplayIntensity(round((value - _targetDomainMin) * 10000.0 / (_targetDomainMax - _targetDomainMin)));
 }
 
 inline double RView::GetDisplayMinSource()
@@ -2059,13 +2344,13 @@ inline double RView::GetDisplayMaxSource()
 inline void RView::SetDisplayMinSource(double value)
 {
 	_sourceDisplayMin = value;
-	_sourceLookupTable->SetMinDisplayIntensity(round((value - _sourceMin) * 10000.0 / (_sourceMax - _sourceMin)));
+	_sourceLookupTable->SetMinDisplayIntensity(round((value - _sourceDomainMin) * 10000.0 / (_sourceDomainMax - _sourceDomainMin)));
 }
 
 inline void RView::SetDisplayMaxSource(double value)
 {
 	_sourceDisplayMax = value;
-	_sourceLookupTable->SetMaxDisplayIntensity(round((value - _sourceMin) * 10000.0 / (_sourceMax - _sourceMin)));
+	_sourceLookupTable->SetMaxDisplayIntensity(round((value - _sourceDomainMin) * 10000.0 / (_sourceDomainMax - _sourceDomainMin)));
 }
 
 inline double RView::GetDisplayMinSubtraction()
@@ -2081,13 +2366,13 @@ inline double RView::GetDisplayMaxSubtraction()
 inline void RView::SetDisplayMinSubtraction(double value)
 {
 	_subtractionDisplayMin = value;
-	_subtractionLookupTable->SetMinDisplayIntensity(round(value * 20000.0 / (_subtractionMax - _subtractionMin)));
+	_subtractionLookupTable->SetMinDisplayIntensity(round(value * 2.0 * SHRT_MAX / (_subtractionMax - _subtractionMin)));
 }
 
 inline void RView::SetDisplayMaxSubtraction(double value)
 {
 	_subtractionDisplayMax = value;
-	_subtractionLookupTable->SetMaxDisplayIntensity(round(value * 20000.0 / (_subtractionMax - _subtractionMin)));
+	_subtractionLookupTable->SetMaxDisplayIntensity(round(value * 2.0 * SHRT_MAX / (_subtractionMax - _subtractionMin)));
 }
 
 #endif
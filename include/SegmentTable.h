@@ -16,6 +16,18 @@
 
 #include <Segment.h>
 #include <limits.h>
+#include <map>
+#include <vector>
+
+/// Compact display properties of a segment used for blending
+struct SegmentDisplay
+{
+  /// Colour and opacity (RGBA8), opacity is 0 for invisible segments
+  unsigned char r, g, b, a;
+
+  /// Opacity in 8-bit fixed point (0 = transparent, 256 = opaque)
+  unsigned int alpha;
+};
 
 class SegmentTable
 {
@@ -25,8 +37,38 @@ class SegmentTable
 
 protected:
 
-  /// Segment Table
-  Segment _entry[SHRT_MAX+1];
+  /// Label IDs of active segments (sorted, used as index)
+  std::vector<int> _id;
+
+  /// Active segments (same order as label IDs)
+  std::vector<Segment *> _segment;
+
+  /// Segment returned for labels which are not in the table
+  Segment _default;
+
+  /// Version of the table (incremented whenever a segment changes)
+  int _version;
+
+  /// Display properties of labels up to SHRT_MAX (direct lookup)
+  SegmentDisplay _display[SHRT_MAX+1];
+
+  /// Display properties of active labels above SHRT_MAX
+  std::map<int, SegmentDisplay> _displayLarge;
+
+  /// Display properties of labels which are not in the table
+  SegmentDisplay _displayDefault;
+
+  /// Find position of label in list of active segments (-1 if not found)
+  int Find(int) const;
+
+  /// Find segment of label (default segment if not found)
+  const Segment *Lookup(int) const;
+
+  /// Find segment of label, inserting a new segment if not found
+  Segment *Insert(int);
+
+  /// Update display properties of segment
+  void UpdateDisplay(int);
 
 public:
 
@@ -39,8 +81,17 @@ public:
   /// Destructor
   virtual ~SegmentTable();
 
-  /// Size of lookup table
-  int Size();
+  /// Number of active segments
+  int NumberOfSegments() const;
+
+  /// Label ID of i-th active segment (in ascending order)
+  int GetSegmentId(int) const;
+
+  /// Version of the table
+  int GetVersion();
+
+  /// Display properties of the segment of a label
+  const SegmentDisplay *GetDisplay(int) const;
 
   /// Sets all values for a segment
   void Set(int, char*, unsigned char, unsigned char, unsigned char, double, int);
@@ -91,43 +142,69 @@ public:
   void Write(char *);
 };
 
+inline const Segment *SegmentTable::Lookup(int id) const
+{
+  int i = this->Find(id);
+
+  return (i < 0) ? &_default : _segment[i];
+}
+
 inline void SegmentTable::GetColor(int id, unsigned char* r, unsigned char* g, unsigned char* b)
 {
-  _entry[id].getColor(r, g, b);
+  this->Lookup(id)->getColor(r, g, b);
 }
 
 inline void SegmentTable::GetTrans(int id, double* d)
 {
-  *d = _entry[id].getTrans();
+  *d = this->Lookup(id)->getTrans();
 }
 
 inline void SegmentTable::GetHex(int id, char* h)
 {
-  _entry[id].getHex(h);
+  this->Lookup(id)->getHex(h);
 }
 
 inline char *SegmentTable::GetLabel(int id)
 {
-  return _entry[id].getLabel();
+  return this->Lookup(id)->getLabel();
 }
 
 inline int SegmentTable::GetVisibility(int id)
 {
-  return _entry[id].getVisibility();
+  return this->Lookup(id)->getVisibility();
 }
 
 inline int SegmentTable::IsValid(int id)
 {
-  if (_entry[id].getLabel() != NULL) {
+  if (this->Find(id) >= 0) {
     return true;
   } else {
     return false;
   }
 }
 
-inline int SegmentTable::Size()
+inline int SegmentTable::NumberOfSegments() const
+{
+  return _id.size();
+}
+
+inline int SegmentTable::GetSegmentId(int i) const
 {
-  return SHRT_MAX+1;
+  return _id[i];
+}
+
+inline int SegmentTable::GetVersion()
+{
+  return _version;
+}
+
+inline const SegmentDisplay *SegmentTable::GetDisplay(int id) const
+{
+  std::map<int, SegmentDisplay>::const_iterator it;
+
+  if ((id >= 0) && (id <= SHRT_MAX)) return &_display[id];
+  it = _displayLarge.find(id);
+  return (it == _displayLarge.end()) ? &_displayDefault : &it->second;
 }
 
 #endif
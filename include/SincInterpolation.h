@@ -0,0 +1,77 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#ifndef _SINCINTERPOLATION_H
+
+#define _SINCINTERPOLATION_H
+
+#include <mirtk/Image.h>
+
+#include <vector>
+
+/// Number of samples on each side of a point weighted by the windowed sinc
+#define SINC_INTERPOLATION_RADIUS 3
+
+/// Number of sub-sample phases at which the weights are tabulated
+#define SINC_INTERPOLATION_PHASES 256
+
+/// Class for Lanczos windowed sinc interpolation of an image frame with tabulated weights
+class SincInterpolation
+{
+
+protected:
+
+  /// Weights of the 2 * RADIUS samples around a point for each phase
+  std::vector<float> _table;
+
+  /// Image and frame whose voxels are interpolated
+  mirtk::Image *_image;
+  int _frame;
+
+  /// Size of the image
+  int _x, _y, _z;
+
+  /// Voxels of the frame
+  std::vector<float> _voxels;
+
+  /// Weights of the samples around a voxel coordinate, the index of the first sample is returned in the argument
+  const float *Weights(double, int &) const;
+
+public:
+
+  /// Constructor
+  SincInterpolation();
+
+  /// Discard the voxels, e.g. when the image has been replaced
+  void Clear();
+
+  /// Interpolate a frame of an image (keeps the voxels if nothing changed)
+  void Initialize(mirtk::Image *, int);
+
+  /// Whether a voxel position lies within the image
+  bool IsInside(double, double, double) const;
+
+  /// Interpolate at a voxel position
+  double Evaluate(double, double, double) const;
+
+  /// Reslice a plane aligned with the image axes separably (false if it is not aligned),
+  /// pixels outside the image are set to the padding value
+  bool ReslicePlane(mirtk::Image *, std::vector<double> &, double) const;
+
+};
+
+inline bool SincInterpolation::IsInside(double x, double y, double z) const
+{
+  return ((x > -0.5) && (y > -0.5) && (z > -0.5) && (x < _x - 0.5) && (y < _y - 0.5) && (z < _z - 0.5));
+}
+
+#endif
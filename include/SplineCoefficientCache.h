@@ -0,0 +1,81 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#ifndef _SPLINECOEFFICIENTCACHE_H
+
+#define _SPLINECOEFFICIENTCACHE_H
+
+#include <mirtk/Image.h>
+
+#include <vector>
+
+/// Default memory limit of the cached coefficient volumes (MB)
+#define SPLINE_COEFFICIENT_CACHE_MEMORY 512
+
+/// Class for cubic B-spline coefficients of the frames of an image, prefiltered once and kept until evicted
+class SplineCoefficientCache
+{
+
+protected:
+
+  /// Image whose frames are prefiltered
+  mirtk::Image *_image;
+
+  /// Coefficients of each frame (empty if not computed)
+  std::vector<std::vector<float> > _coefficients;
+
+  /// Time stamp of last use of each frame
+  std::vector<long> _lastUse;
+
+  /// Current time stamp
+  long _clock;
+
+  /// Number of voxels of a frame
+  int _frameSize;
+
+  /// Memory limit of the cached frames (bytes)
+  double _memoryLimit;
+
+  /// Compute coefficients of a frame
+  void ComputeFrame(int);
+
+public:
+
+  /// Constructor
+  SplineCoefficientCache();
+
+  /// Discard all coefficients, e.g. when the image has been replaced
+  void Clear();
+
+  /// Set memory limit of the cached frames (MB)
+  void SetMemoryLimit(int);
+
+  /// Coefficients of a frame of an image, computed in parallel if they are not cached
+  const float *GetCoefficients(mirtk::Image *, int);
+
+  /// Number of frames whose coefficients are cached
+  int GetNumberOfFrames() const;
+
+  /// Evaluate the cubic B-spline of coefficients of an image frame at a voxel position
+  static double Evaluate(const float *, int, int, int, double, double, double);
+
+  /// Whether a voxel position lies within the domain in which the spline is evaluated
+  static bool IsInside(int, int, int, double, double, double);
+
+};
+
+inline bool SplineCoefficientCache::IsInside(int nx, int ny, int nz, double x, double y, double z)
+{
+  return ((x > -0.5) && (y > -0.5) && (z > -0.5) && (x < nx - 0.5) && (y < ny - 0.5) && (z < nz - 0.5));
+}
+
+#endif
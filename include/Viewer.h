@@ -34,6 +34,61 @@ class Viewer
   /// Viewer mode
   ViewerMode _viewerMode;
 
+  /// OpenGL texture holding the image of the viewer
+  unsigned int _texture;
+
+  /// Size of image in texture (in pixels)
+  int _textureWidth, _textureHeight;
+
+  /// Size of texture (power of two, in pixels)
+  int _textureX, _textureY;
+
+  /// Copy of the texture contents (RGBA)
+  unsigned char *_textureBuffer;
+
+  /// Retained isolines of up to two images (target and source)
+  Overlay _isolines[2];
+
+  /// Images from which the retained isolines were built
+  mirtk::GreyImage *_isolinesImage[2];
+
+  /// Retained segmentation contours
+  Overlay _segmentationContour;
+
+  /// Retained tag grid
+  Overlay _tagGrid;
+
+  /// Retained deformation grid, points and arrows
+  Overlay _deformationGrid, _deformationPoints, _deformationArrows, _deformationArrowHeads;
+
+  /// Versions of deformation and tag grid (incremented whenever recomputed)
+  int _deformationVersion, _tagGridVersion;
+
+  /// Number of (control) points along each axis of the viewer
+  int _NumberOfX, _NumberOfY;
+
+  /// Plane, transformation, time and display settings of the current (control) points
+  std::vector<double> _deformationKey;
+
+  /// Points before and after transformation (image coordinates, stored row by row)
+  std::vector<double> _BeforeX, _BeforeY, _BeforeZ, _AfterX, _AfterY, _AfterZ;
+
+  /// Points of deformation grid (image coordinates, stored row by row)
+  std::vector<double> _AfterGridX, _AfterGridY, _AfterGridZ;
+
+  /// Status of control points
+  std::vector<mirtk::Transformation::DOFStatus> _CPStatus;
+
+  /// Number of points of tag grid along each axis
+  int _NumberOfTagGridX, _NumberOfTagGridY;
+
+  /// Points of tag grid before and after transformation (image coordinates, stored row by row)
+  std::vector<double> _BeforeTagGridX, _BeforeTagGridY, _BeforeTagGridZ;
+  std::vector<double> _AfterTagGridX, _AfterTagGridY, _AfterTagGridZ;
+
+  /// Resize buffers of points to the current number of (control) points
+  void AllocatePoints();
+
 public:
 
   /// Constructor
@@ -42,14 +97,14 @@ public:
   /// Destructor
   virtual ~Viewer();
 
-  /// Draw image viewer
-  virtual void DrawImage(Color *);
+  /// Draw image viewer (only uploads changed rows if the image was modified)
+  virtual void DrawImage(Color *, bool = true);
 
-  /// Draw isolines in image viewer
-  virtual void DrawIsolines(mirtk::GreyImage *, int);
+  /// Draw isolines for given iso-values (rebuilt if image version or values changed)
+  virtual void DrawIsolines(mirtk::GreyImage *, int, const double *, int);
 
-  /// Draw segmentation contours in image viewer
-  virtual void DrawSegmentationContour(mirtk::GreyImage *);
+  /// Draw segmentation contours in image viewer (rebuilt if version changed)
+  virtual void DrawSegmentationContour(mirtk::GenericImage<int> *, int);
 
   /// Draw cursor in image viewer
   virtual void DrawCursor(CursorMode mode);
@@ -0,0 +1,947 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#include <mirtk/Image.h>
+#include <mirtk/Transformation.h>
+#include <mirtk/HomogeneousTransformation.h>
+#include <mirtk/FreeFormTransformation.h>
+#include <mirtk/MultiLevelFreeFormTransformation.h>
+#include <mirtk/Parallel.h>
+
+#include <DisplacementCache.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <utime.h>
+#include <unistd.h>
+
+/// Number of grid points along each edge of a cache tile
+#define DISPLACEMENT_CACHE_POINTS (DISPLACEMENT_CACHE_TILE + 1)
+
+/// Every how many cells along each edge of a tile the inverse-consistency error is sampled
+#define DISPLACEMENT_CACHE_ERROR_STEP 2
+
+/// Displacement of a world point by a chain of transformations applied in order
+static void ChainDisplacement(const std::vector<mirtk::Transformation *> &chain, double &x, double &y, double &z, double t, double t0)
+{
+  int i;
+  double u, v, w;
+
+  if (chain.size() == 1) {
+    chain[0]->Displacement(x, y, z, t, t0);
+    return;
+  }
+  u = x;
+  v = y;
+  w = z;
+  for (i = 0; i < int(chain.size()); i++) {
+    chain[i]->Transform(u, v, w, t, t0);
+  }
+  x = u - x;
+  y = v - y;
+  z = w - z;
+}
+
+/// Inverse displacement of a world point by fixed-point iteration from an initial estimate,
+/// returns the inverse-consistency error of the estimate
+static double InverseChainDisplacement(const std::vector<mirtk::Transformation *> &chain, double x, double y, double z,
+                                       double &dx, double &dy, double &dz, double t, double t0)
+{
+  int i;
+  double u, v, w;
+
+  for (i = 0; i <= DISPLACEMENT_CACHE_INVERSE_ITERATIONS; i++) {
+    u = x + dx;
+    v = y + dy;
+    w = z + dz;
+    ChainDisplacement(chain, u, v, w, t, t0);
+
+    // Forward transformation of the estimate should map back onto the point
+    if ((i == DISPLACEMENT_CACHE_INVERSE_ITERATIONS) ||
+        ((dx + u) * (dx + u) + (dy + v) * (dy + v) + (dz + w) * (dz + w) <
+         DISPLACEMENT_CACHE_INVERSE_TOLERANCE * DISPLACEMENT_CACHE_INVERSE_TOLERANCE)) break;
+    dx = -u;
+    dy = -v;
+    dz = -w;
+  }
+  return sqrt((dx + u) * (dx + u) + (dy + v) * (dy + v) + (dz + w) * (dz + w));
+}
+
+/// Evaluation of the displacements at the grid points of a tile
+class TileDisplacement
+{
+public:
+
+  /// Transformations applied in order
+  const std::vector<mirtk::Transformation *> *_transformations;
+
+  /// Grid of the cache
+  const mirtk::ImageAttributes *_attr;
+
+  /// Time of the transformed points and temporal origin
+  double _t, _t0;
+
+  /// Whether inverse displacements are computed
+  bool _inverse;
+
+  /// First grid point of the tile
+  int _i0, _j0, _k0;
+
+  /// Displacements of the tile (output)
+  float *_tile;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, k, n;
+    double x, y, z, dx, dy, dz;
+
+    for (k = re.begin(); k != re.end(); k++) {
+      n = 3 * k * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS;
+      for (j = 0; j < DISPLACEMENT_CACHE_POINTS; j++) {
+        for (i = 0; i < DISPLACEMENT_CACHE_POINTS; i++, n += 3) {
+          x = _i0 + i;
+          y = _j0 + j;
+          z = _k0 + k;
+          _attr->LatticeToWorld(x, y, z);
+          if (_inverse == true) {
+            // Start from the inverse of the previous point of the row or from the negated forward displacement
+            if (i == 0) {
+              dx = x;
+              dy = y;
+              dz = z;
+              ChainDisplacement(*_transformations, dx, dy, dz, _t, _t0);
+              dx = -dx;
+              dy = -dy;
+              dz = -dz;
+            }
+            InverseChainDisplacement(*_transformations, x, y, z, dx, dy, dz, _t, _t0);
+          } else {
+            dx = x;
+            dy = y;
+            dz = z;
+            ChainDisplacement(*_transformations, dx, dy, dz, _t, _t0);
+          }
+          _tile[n]     = dx;
+          _tile[n + 1] = dy;
+          _tile[n + 2] = dz;
+        }
+      }
+    }
+  }
+};
+
+/// Inverse-consistency error of the trilinearly interpolated inverse displacements of a tile,
+/// sampled at cell centres inside the grid
+class TileInverseError
+{
+public:
+
+  /// Transformations applied in order
+  const std::vector<mirtk::Transformation *> *_transformations;
+
+  /// Grid of the cache
+  const mirtk::ImageAttributes *_attr;
+
+  /// Time of the transformed points and temporal origin
+  double _t, _t0;
+
+  /// First grid point of the tile
+  int _i0, _j0, _k0;
+
+  /// Inverse displacements of the tile
+  const float *_tile;
+
+  /// Sum, maximum and number of samples of the error of each sampled slice of the tile (output)
+  double *_errorSum, *_errorMax;
+  int *_errorCount;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, k, l, m, n, ni, nj, nk, c;
+    double x, y, z, fx, fy, fz, d[3], e;
+
+    // Cells at the border of the grid are only partially visible, grids with a single slice have no cells along z
+    ni = (_attr->_x > 1) ? std::min(DISPLACEMENT_CACHE_TILE, _attr->_x - 1 - _i0) : 1;
+    nj = (_attr->_y > 1) ? std::min(DISPLACEMENT_CACHE_TILE, _attr->_y - 1 - _j0) : 1;
+    nk = (_attr->_z > 1) ? std::min(DISPLACEMENT_CACHE_TILE, _attr->_z - 1 - _k0) : 1;
+    fx = (_attr->_x > 1) ? 0.5 : 0;
+    fy = (_attr->_y > 1) ? 0.5 : 0;
+    fz = (_attr->_z > 1) ? 0.5 : 0;
+
+    for (l = re.begin(); l != re.end(); l++) {
+      _errorSum[l]   = 0;
+      _errorMax[l]   = 0;
+      _errorCount[l] = 0;
+      k = l * DISPLACEMENT_CACHE_ERROR_STEP;
+      if (k >= nk) continue;
+      for (j = 0; j < nj; j += DISPLACEMENT_CACHE_ERROR_STEP) {
+        for (i = 0; i < ni; i += DISPLACEMENT_CACHE_ERROR_STEP) {
+
+          // Same interpolation as used for display
+          n = 3 * (i + DISPLACEMENT_CACHE_POINTS * (j + DISPLACEMENT_CACHE_POINTS * k));
+          for (c = 0; c < 3; c++) {
+            m = n + c;
+            d[c] = (1 - fz) * ((1 - fy) * ((1 - fx) * _tile[m] + fx * _tile[m + 3]) +
+                               fy * ((1 - fx) * _tile[m + 3 * DISPLACEMENT_CACHE_POINTS] + fx * _tile[m + 3 * DISPLACEMENT_CACHE_POINTS + 3]));
+            if (fz > 0) {
+              m += 3 * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS;
+              d[c] += fz * ((1 - fy) * ((1 - fx) * _tile[m] + fx * _tile[m + 3]) +
+                            fy * ((1 - fx) * _tile[m + 3 * DISPLACEMENT_CACHE_POINTS] + fx * _tile[m + 3 * DISPLACEMENT_CACHE_POINTS + 3]));
+            }
+          }
+
+          // Forward transformation of the inverse mapped cell centre should map back onto it
+          x = _i0 + i + fx;
+          y = _j0 + j + fy;
+          z = _k0 + k + fz;
+          _attr->LatticeToWorld(x, y, z);
+          x += d[0];
+          y += d[1];
+          z += d[2];
+          ChainDisplacement(*_transformations, x, y, z, _t, _t0);
+          e = sqrt((d[0] + x) * (d[0] + x) + (d[1] + y) * (d[1] + y) + (d[2] + z) * (d[2] + z));
+          _errorSum[l] += e;
+          if (e > _errorMax[l]) _errorMax[l] = e;
+          _errorCount[l]++;
+        }
+      }
+    }
+  }
+};
+
+/// Size of a tile in bytes
+#define DISPLACEMENT_CACHE_TILE_SIZE (3 * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS * sizeof(float))
+
+/// Prefix and extension of tile files in the cache directory, other files are never touched
+#define DISPLACEMENT_CACHE_PREFIX    "rview_"
+#define DISPLACEMENT_CACHE_EXTENSION ".dsp"
+
+/// Age after which temporary tile files are assumed to be left behind by sessions which died (s)
+#define DISPLACEMENT_CACHE_STALE 3600
+
+/// Kinds of files in the cache directory
+enum CacheFileType { CacheFile_Other, CacheFile_Tile, CacheFile_Temporary };
+
+/// Kind of a file in the cache directory by its name
+static CacheFileType GetCacheFileType(const char *name)
+{
+  const char *ptr;
+
+  if (strncmp(name, DISPLACEMENT_CACHE_PREFIX, strlen(DISPLACEMENT_CACHE_PREFIX)) != 0) return CacheFile_Other;
+  ptr = strstr(name + strlen(DISPLACEMENT_CACHE_PREFIX), DISPLACEMENT_CACHE_EXTENSION);
+  if (ptr == NULL) return CacheFile_Other;
+  ptr += strlen(DISPLACEMENT_CACHE_EXTENSION);
+  if (*ptr == '\0') return CacheFile_Tile;
+
+  // Temporary files append the process ID to the name of the tile
+  if ((*ptr != '.') || (ptr[1] == '\0') || (strspn(ptr + 1, "0123456789") != strlen(ptr + 1))) return CacheFile_Other;
+  return CacheFile_Temporary;
+}
+
+/// Add bytes to a 64 bit FNV-1a hash
+static void Hash(unsigned long long &key, const void *data, int n)
+{
+  int i;
+  const unsigned char *ptr;
+
+  ptr = static_cast<const unsigned char *>(data);
+  for (i = 0; i < n; i++) {
+    key ^= ptr[i];
+    key *= 1099511628211ULL;
+  }
+}
+
+/// Add the geometry of an image lattice to the hash key
+static void HashAttributes(unsigned long long &key, const mirtk::ImageAttributes &attr)
+{
+  Hash(key, &attr._x, sizeof(attr._x));
+  Hash(key, &attr._y, sizeof(attr._y));
+  Hash(key, &attr._z, sizeof(attr._z));
+  Hash(key, &attr._xorigin, sizeof(attr._xorigin));
+  Hash(key, &attr._yorigin, sizeof(attr._yorigin));
+  Hash(key, &attr._zorigin, sizeof(attr._zorigin));
+  Hash(key, &attr._dx, sizeof(attr._dx));
+  Hash(key, &attr._dy, sizeof(attr._dy));
+  Hash(key, &attr._dz, sizeof(attr._dz));
+  Hash(key, attr._xaxis, sizeof(attr._xaxis));
+  Hash(key, attr._yaxis, sizeof(attr._yaxis));
+  Hash(key, attr._zaxis, sizeof(attr._zaxis));
+}
+
+/// Add everything the displacements of a transformation depend on to the hash key
+static void HashTransformation(unsigned long long &key, mirtk::Transformation *transformation)
+{
+  int i, l, n;
+  bool active;
+  double value;
+  mirtk::ExtrapolationMode mode;
+  mirtk::MultiLevelFreeFormTransformation *mffd;
+  mirtk::FreeFormTransformation *ffd;
+
+  Hash(key, transformation->NameOfClass(), strlen(transformation->NameOfClass()));
+  n = transformation->NumberOfDOFs();
+  Hash(key, &n, sizeof(n));
+  for (i = 0; i < n; i++) {
+    value = transformation->Get(i);
+    Hash(key, &value, sizeof(value));
+  }
+
+  // Control point values alone do not tell where the lattice is or which levels are used
+  mffd = dynamic_cast<mirtk::MultiLevelFreeFormTransformation *>(transformation);
+  if (mffd != NULL) {
+    n = mffd->NumberOfLevels();
+    Hash(key, &n, sizeof(n));
+    for (l = 0; l < n; l++) {
+      active = mffd->LocalTransformationIsActive(l);
+      Hash(key, &active, sizeof(active));
+      HashTransformation(key, mffd->GetLocalTransformation(l));
+    }
+    return;
+  }
+  ffd = dynamic_cast<mirtk::FreeFormTransformation *>(transformation);
+  if (ffd != NULL) {
+    HashAttributes(key, ffd->Attributes());
+    mode = ffd->ExtrapolationMode();
+    Hash(key, &mode, sizeof(mode));
+  }
+}
+
+/// File in the cache directory with its size and time of last use
+struct CacheFile
+{
+  char   _name[1024];
+  double _size;
+  time_t _time;
+
+  bool operator<(const CacheFile &other) const
+  {
+    return (_time < other._time);
+  }
+};
+
+DisplacementCache::DisplacementCache()
+{
+  _maxNumberOfTiles = 0;
+  _directory = NULL;
+  _diskSize  = 0;
+  _diskLimit = 0;
+  _key       = 0;
+  _inverse   = false;
+  this->SetMemoryLimit(DISPLACEMENT_CACHE_MEMORY);
+  this->SetDiskLimit(DISPLACEMENT_CACHE_DISK);
+  this->Clear();
+}
+
+DisplacementCache::~DisplacementCache()
+{
+  if (_directory != NULL) free(_directory);
+}
+
+void DisplacementCache::Clear()
+{
+  _transformations.clear();
+  _t        = 0;
+  _t0       = 0;
+  _version  = 0;
+  _nx       = 0;
+  _ny       = 0;
+  _nz       = 0;
+  _clock    = 0;
+  _frame    = -1;
+  _timeVarying   = false;
+  _numberOfTiles = 0;
+  _numberOfFrameTiles = 0;
+  _workingStamp  = 0;
+  _inverseErrorSum   = 0;
+  _inverseErrorMax   = 0;
+  _inverseErrorCount = 0;
+  std::vector<std::vector<float> >().swap(_tiles);
+  std::vector<long>().swap(_lastUse);
+  std::vector<int>().swap(_required);
+  std::vector<double>().swap(_frameT);
+  std::vector<double>().swap(_frameT0);
+  std::vector<long>().swap(_frameUse);
+  std::vector<unsigned long long>().swap(_frameKey);
+  std::vector<int>().swap(_workingSet);
+  std::vector<long>().swap(_workingUse);
+}
+
+void DisplacementCache::Initialize(mirtk::Transformation *transformation, int version, const mirtk::ImageAttributes &attr, double t, double t0)
+{
+  std::vector<mirtk::Transformation *> chain;
+
+  if (transformation != NULL) chain.push_back(transformation);
+  this->Initialize(chain, version, attr, t, t0);
+}
+
+void DisplacementCache::Initialize(const std::vector<mirtk::Transformation *> &chain, int version, const mirtk::ImageAttributes &attr, double t, double t0)
+{
+  int i, j;
+  bool timeVarying;
+
+  // Displacements of transformations which do not depend on time are shared by all frames
+  timeVarying = false;
+  for (i = 0; i < int(chain.size()); i++) {
+    if (IsTimeVarying(chain[i]) == true) timeVarying = true;
+  }
+  if (timeVarying != true) {
+    t  = 0;
+    t0 = 0;
+  }
+
+  // Tiles are still valid for the same transformations and grid, those of other frames are kept
+  if ((_transformations.empty() != true) && (chain == _transformations) && (version == _version) && (attr == _attr)) {
+    if ((t != _t) || (t0 != _t0)) this->SelectFrame(t, t0);
+    return;
+  }
+  this->Clear();
+  if (chain.empty() == true) return;
+
+  _transformations = chain;
+  _version = version;
+  _attr = attr;
+  _timeVarying = timeVarying;
+  _nx   = (attr._x > 1) ? (attr._x - 2) / DISPLACEMENT_CACHE_TILE + 1 : 1;
+  _ny   = (attr._y > 1) ? (attr._y - 2) / DISPLACEMENT_CACHE_TILE + 1 : 1;
+  _nz   = (attr._z > 1) ? (attr._z - 2) / DISPLACEMENT_CACHE_TILE + 1 : 1;
+  _numberOfFrameTiles = _nx * _ny * _nz;
+  _tiles.reserve(DISPLACEMENT_CACHE_FRAMES * _numberOfFrameTiles);
+  _workingUse.assign(_numberOfFrameTiles, -1);
+  _clock = 0;
+
+  // Tiles stored by previous sessions are found by the hash of everything they depend on
+  if (_directory != NULL) {
+    _key = 14695981039346656037ULL;
+    for (j = 0; j < int(chain.size()); j++) {
+      HashTransformation(_key, chain[j]);
+    }
+    HashAttributes(_key, attr);
+    Hash(_key, &_inverse, sizeof(_inverse));
+  }
+  this->SelectFrame(t, t0);
+}
+
+bool DisplacementCache::IsTimeVarying(mirtk::Transformation *transformation)
+{
+  int l;
+  mirtk::MultiLevelFreeFormTransformation *mffd;
+
+  // Linear transformations and spatial FFDs displace points independently of their time
+  if (dynamic_cast<mirtk::HomogeneousTransformation *>(transformation) != NULL) return false;
+  mffd = dynamic_cast<mirtk::MultiLevelFreeFormTransformation *>(transformation);
+  if (mffd != NULL) {
+    for (l = 0; l < mffd->NumberOfLevels(); l++) {
+      if (IsTimeVarying(mffd->GetLocalTransformation(l)) == true) return true;
+    }
+    return false;
+  }
+  return ((transformation->TypeOfClass() != mirtk::TRANSFORMATION_BSPLINE_FFD_3D) &&
+          (transformation->TypeOfClass() != mirtk::TRANSFORMATION_LINEAR_FFD_3D));
+}
+
+int DisplacementCache::FindFrame(double t, double t0)
+{
+  int f, i;
+
+  for (f = 0; f < int(_frameT.size()); f++) {
+    if ((_frameT[f] == t) && (_frameT0[f] == t0)) return f;
+  }
+
+  if (f < DISPLACEMENT_CACHE_FRAMES) {
+    // Add tiles of another frame pair
+    _frameT.push_back(t);
+    _frameT0.push_back(t0);
+    _frameUse.push_back(_clock);
+    _frameKey.push_back(0);
+    _tiles.resize((f + 1) * _numberOfFrameTiles);
+    _lastUse.resize((f + 1) * _numberOfFrameTiles, -1);
+  } else {
+    // Discard tiles of the least recently used frame pair other than the current one
+    f = -1;
+    for (i = 0; i < int(_frameT.size()); i++) {
+      if ((i != _frame) && ((f < 0) || (_frameUse[i] < _frameUse[f]))) f = i;
+    }
+    for (i = f * _numberOfFrameTiles; i < (f + 1) * _numberOfFrameTiles; i++) {
+      if (_tiles[i].empty() == false) {
+        std::vector<float>().swap(_tiles[i]);
+        _numberOfTiles--;
+      }
+      _lastUse[i] = -1;
+    }
+    _frameT[f]   = t;
+    _frameT0[f]  = t0;
+    _frameUse[f] = _clock;
+  }
+
+  if (_directory != NULL) {
+    _frameKey[f] = _key;
+    Hash(_frameKey[f], &t, sizeof(t));
+    Hash(_frameKey[f], &t0, sizeof(t0));
+  }
+  return f;
+}
+
+void DisplacementCache::SelectFrame(double t, double t0)
+{
+  int f;
+
+  f = this->FindFrame(t, t0);
+
+  // Tiles required by the planes of the previous frame pair are not known to be required by this one
+  if (f != _frame) {
+    _workingSet.clear();
+    _workingStamp++;
+  }
+  _frame = f;
+  _t  = t;
+  _t0 = t0;
+  _frameUse[f] = _clock;
+}
+
+void DisplacementCache::SetMemoryLimit(int mb)
+{
+  int n;
+
+  // Tiles required by a single plane are always kept
+  n = 3 * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS * sizeof(float);
+  _maxNumberOfTiles = int(mb * 1024.0 * 1024.0 / n);
+  if (_maxNumberOfTiles < 1) _maxNumberOfTiles = 1;
+}
+
+void DisplacementCache::SetDirectory(const char *directory)
+{
+  struct stat info;
+
+  if (_directory != NULL) free(_directory);
+  _directory = NULL;
+
+  // Tiles of the current transformation need to be looked up again
+  this->Clear();
+  if (directory == NULL) return;
+
+  if ((stat(directory, &info) != 0) && (mkdir(directory, 0755) != 0)) {
+    std::cerr << "DisplacementCache::SetDirectory: Cannot create " << directory << std::endl;
+    return;
+  }
+  _directory = strdup(directory);
+  this->TrimDirectory();
+}
+
+void DisplacementCache::SetDiskLimit(int mb)
+{
+  _diskLimit = mb * 1024.0 * 1024.0;
+  if (_directory != NULL) this->TrimDirectory();
+}
+
+bool DisplacementCache::TileFileName(int n, char *name, int size) const
+{
+  int length;
+
+  length = snprintf(name, size, "%s/" DISPLACEMENT_CACHE_PREFIX "%016llx_%d" DISPLACEMENT_CACHE_EXTENSION, _directory, _frameKey[n / _numberOfFrameTiles], n % _numberOfFrameTiles);
+  return ((length >= 0) && (length < size));
+}
+
+bool DisplacementCache::ReadTile(int n)
+{
+  FILE *fp;
+  char name[1024];
+  size_t size;
+
+  if (this->TileFileName(n, name, sizeof(name)) != true) return false;
+  fp = fopen(name, "rb");
+  if (fp == NULL) return false;
+  _tiles[n].resize(DISPLACEMENT_CACHE_TILE_SIZE / sizeof(float));
+  size = fread(&_tiles[n][0], 1, DISPLACEMENT_CACHE_TILE_SIZE, fp);
+  fclose(fp);
+  if (size != DISPLACEMENT_CACHE_TILE_SIZE) {
+    std::vector<float>().swap(_tiles[n]);
+    return false;
+  }
+
+  // Modification time records the last use of a file
+  utime(name, NULL);
+  return true;
+}
+
+void DisplacementCache::WriteTile(int n)
+{
+  FILE *fp;
+  char name[1024], temp[1024];
+  int length;
+  size_t size;
+
+  // Write to a temporary file first so that other sessions never read a partial tile
+  if (this->TileFileName(n, name, sizeof(name)) != true) return;
+  length = snprintf(temp, sizeof(temp), "%s.%d", name, int(getpid()));
+  if ((length < 0) || (length >= int(sizeof(temp)))) return;
+  fp = fopen(temp, "wb");
+  if (fp == NULL) return;
+  size = fwrite(&_tiles[n][0], 1, DISPLACEMENT_CACHE_TILE_SIZE, fp);
+  fclose(fp);
+  if ((size != DISPLACEMENT_CACHE_TILE_SIZE) || (rename(temp, name) != 0)) {
+    remove(temp);
+    return;
+  }
+  _diskSize += DISPLACEMENT_CACHE_TILE_SIZE;
+  if (_diskSize > _diskLimit) this->TrimDirectory();
+}
+
+void DisplacementCache::TrimDirectory()
+{
+  int i;
+  DIR *dir;
+  struct dirent *entry;
+  struct stat info;
+  CacheFile file;
+  CacheFileType type;
+  std::vector<CacheFile> files;
+  time_t now;
+
+  dir = opendir(_directory);
+  if (dir == NULL) return;
+
+  // Size of all tile files, temporary files of sessions which died before renaming them are removed
+  _diskSize = 0;
+  now = time(NULL);
+  while ((entry = readdir(dir)) != NULL) {
+    type = GetCacheFileType(entry->d_name);
+    if (type == CacheFile_Other) continue;
+    snprintf(file._name, sizeof(file._name), "%s/%s", _directory, entry->d_name);
+    if (stat(file._name, &info) != 0) continue;
+    if ((type == CacheFile_Temporary) && (difftime(now, info.st_mtime) > DISPLACEMENT_CACHE_STALE) && (remove(file._name) == 0)) continue;
+    file._size = info.st_size;
+    file._time = info.st_mtime;
+    _diskSize += file._size;
+    if (type == CacheFile_Tile) files.push_back(file);
+  }
+  closedir(dir);
+
+  // Delete least recently used tiles until there is room for new tiles again
+  if (_diskSize <= _diskLimit) return;
+  std::sort(files.begin(), files.end());
+  for (i = 0; (i < int(files.size())) && (_diskSize > 0.9 * _diskLimit); i++) {
+    if (remove(files[i]._name) == 0) _diskSize -= files[i]._size;
+  }
+}
+
+void DisplacementCache::Require(double x, double y, double z)
+{
+  int i, j, k, n;
+
+  if (_transformations.empty() == true) return;
+  _attr.WorldToLattice(x, y, z);
+  if ((x < 0) || (y < 0) || (z < 0) || (x > _attr._x - 1) || (y > _attr._y - 1) || (z > _attr._z - 1)) return;
+  i = int(x) / DISPLACEMENT_CACHE_TILE;
+  j = int(y) / DISPLACEMENT_CACHE_TILE;
+  k = int(z) / DISPLACEMENT_CACHE_TILE;
+  if (i >= _nx) i = _nx - 1;
+  if (j >= _ny) j = _ny - 1;
+  if (k >= _nz) k = _nz - 1;
+  n = i + _nx * (j + _ny * k);
+  if (_workingUse[n] != _workingStamp) {
+    _workingUse[n] = _workingStamp;
+    _workingSet.push_back(n);
+  }
+  n += _frame * _numberOfFrameTiles;
+  if (_lastUse[n] != _clock) {
+    _lastUse[n] = _clock;
+    _required.push_back(n);
+  }
+}
+
+void DisplacementCache::ComputeTile(int n)
+{
+  int f, k;
+  bool stored;
+  double errorSum[DISPLACEMENT_CACHE_POINTS], errorMax[DISPLACEMENT_CACHE_POINTS];
+  int errorCount[DISPLACEMENT_CACHE_POINTS];
+  TileDisplacement body;
+  TileInverseError error;
+
+  f = n / _numberOfFrameTiles;
+  k = n % _numberOfFrameTiles;
+  body._transformations = &_transformations;
+  body._attr = &_attr;
+  body._t    = _frameT[f];
+  body._t0   = _frameT0[f];
+  body._inverse = _inverse;
+  body._i0   = (k % _nx) * DISPLACEMENT_CACHE_TILE;
+  body._j0   = (k / _nx % _ny) * DISPLACEMENT_CACHE_TILE;
+  body._k0   = (k / (_nx * _ny)) * DISPLACEMENT_CACHE_TILE;
+
+  stored = ((_directory != NULL) && (this->ReadTile(n) == true));
+  if (stored != true) {
+    _tiles[n].resize(3 * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS);
+    body._tile = &_tiles[n][0];
+    mirtk::parallel_for(mirtk::blocked_range<int>(0, DISPLACEMENT_CACHE_POINTS), body);
+  }
+  _numberOfTiles++;
+
+  // Error of the inverse as it is seen, i.e. between the grid points where it has been computed,
+  // also for tiles stored by previous sessions
+  if (_inverse == true) {
+    error._transformations = &_transformations;
+    error._attr = &_attr;
+    error._t    = body._t;
+    error._t0   = body._t0;
+    error._i0   = body._i0;
+    error._j0   = body._j0;
+    error._k0   = body._k0;
+    error._tile = &_tiles[n][0];
+    error._errorSum   = errorSum;
+    error._errorMax   = errorMax;
+    error._errorCount = errorCount;
+    mirtk::parallel_for(mirtk::blocked_range<int>(0, DISPLACEMENT_CACHE_TILE / DISPLACEMENT_CACHE_ERROR_STEP), error);
+    for (k = 0; k < DISPLACEMENT_CACHE_TILE / DISPLACEMENT_CACHE_ERROR_STEP; k++) {
+      _inverseErrorSum   += errorSum[k];
+      _inverseErrorCount += errorCount[k];
+      if (errorMax[k] > _inverseErrorMax) _inverseErrorMax = errorMax[k];
+    }
+  }
+
+  if ((_directory != NULL) && (stored != true)) this->WriteTile(n);
+}
+
+void DisplacementCache::Evict(int max)
+{
+  int i, n;
+
+  while (_numberOfTiles > max) {
+    // Least recently used tile which is not required by the current update
+    n = -1;
+    for (i = 0; i < int(_tiles.size()); i++) {
+      if ((_tiles[i].empty() == false) && (_lastUse[i] != _clock) && ((n < 0) || (_lastUse[i] < _lastUse[n]))) n = i;
+    }
+    if (n < 0) return;
+    std::vector<float>().swap(_tiles[n]);
+    _numberOfTiles--;
+  }
+}
+
+void DisplacementCache::Update()
+{
+  int i, n;
+
+  if (_transformations.empty() == true) return;
+
+  // Make room for the missing tiles before computing them
+  n = 0;
+  for (i = 0; i < int(_required.size()); i++) {
+    if (_tiles[_required[i]].empty() == true) n++;
+  }
+  this->Evict(_maxNumberOfTiles - n);
+  for (i = 0; i < int(_required.size()); i++) {
+    if (_tiles[_required[i]].empty() == true) this->ComputeTile(_required[i]);
+  }
+  _required.clear();
+  _frameUse[_frame] = _clock;
+  _clock++;
+}
+
+bool DisplacementCache::Precompute(double x, double y, double z)
+{
+  int i, j, k, n, m, missing;
+  double d, dmin;
+
+  if ((_transformations.empty() == true) || (_numberOfTiles >= _maxNumberOfTiles)) return false;
+
+  // Tile coordinates of the point
+  _attr.WorldToLattice(x, y, z);
+  x = x / DISPLACEMENT_CACHE_TILE - 0.5;
+  y = y / DISPLACEMENT_CACHE_TILE - 0.5;
+  z = z / DISPLACEMENT_CACHE_TILE - 0.5;
+
+  // Missing tile of the current frame pair closest to the point
+  n    = -1;
+  dmin = 0;
+  missing = 0;
+  for (k = 0; k < _nz; k++) {
+    for (j = 0; j < _ny; j++) {
+      for (i = 0; i < _nx; i++) {
+        m = _frame * _numberOfFrameTiles + i + _nx * (j + _ny * k);
+        if (_tiles[m].empty() == false) continue;
+        missing++;
+        d = (i - x) * (i - x) + (j - y) * (j - y) + (k - z) * (k - z);
+        if ((n < 0) || (d < dmin)) {
+          n    = m;
+          dmin = d;
+        }
+      }
+    }
+  }
+  if (n < 0) return false;
+  this->ComputeTile(n);
+  _lastUse[n] = _clock;
+  return ((missing > 1) && (_numberOfTiles < _maxNumberOfTiles));
+}
+
+bool DisplacementCache::PrecomputeFrame(double t, double t0)
+{
+  int i, f, n;
+
+  if ((_transformations.empty() == true) || (_workingSet.empty() == true)) return false;
+  if (_timeVarying != true) return false;
+
+  // Tiles of another frame pair which the planes of the current one required
+  f = this->FindFrame(t, t0);
+  for (i = 0; i < int(_workingSet.size()); i++) {
+    n = f * _numberOfFrameTiles + _workingSet[i];
+    if (_tiles[n].empty() == false) continue;
+
+    // Make room by discarding tiles which have not been used for the longest time
+    this->Evict(_maxNumberOfTiles - 1);
+    if (_numberOfTiles >= _maxNumberOfTiles) return false;
+    this->ComputeTile(n);
+    _lastUse[n]  = _clock;
+    _frameUse[f] = _clock;
+    return true;
+  }
+  return false;
+}
+
+int DisplacementCache::GetFrameCapacity() const
+{
+  int n;
+
+  if (_workingSet.empty() == true) return 0;
+  n = _maxNumberOfTiles / int(_workingSet.size());
+  return (n < DISPLACEMENT_CACHE_FRAMES) ? n : DISPLACEMENT_CACHE_FRAMES;
+}
+
+void DisplacementCache::SetInverse(bool inverse)
+{
+  if (inverse == _inverse) return;
+  _inverse = inverse;
+  this->Clear();
+}
+
+void DisplacementCache::Transform(double &x, double &y, double &z)
+{
+  double dx, dy, dz;
+
+  if (_transformations.empty() == true) return;
+
+  // Isolated points are inverted directly, inverse tiles are only computed for reslicing and precomputation
+  if (_inverse != true) {
+    this->Require(x, y, z);
+    this->Update();
+  }
+  dx = x;
+  dy = y;
+  dz = z;
+  this->Displacement(dx, dy, dz);
+  x += dx;
+  y += dy;
+  z += dz;
+}
+
+bool DisplacementCache::GetInverseError(double &mean, double &max) const
+{
+  mean = (_inverseErrorCount > 0) ? _inverseErrorSum / _inverseErrorCount : 0;
+  max  = _inverseErrorMax;
+  return (_inverseErrorCount > 0);
+}
+
+double DisplacementCache::GetProgress() const
+{
+  int i, n, max;
+
+  // Fraction of the current frame pair
+  max = (_numberOfFrameTiles < _maxNumberOfTiles) ? _numberOfFrameTiles : _maxNumberOfTiles;
+  if (max == 0) return 0;
+  n = 0;
+  for (i = _frame * _numberOfFrameTiles; i < (_frame + 1) * _numberOfFrameTiles; i++) {
+    if (_tiles[i].empty() == false) n++;
+  }
+  return (n < max) ? double(n) / max : 1.0;
+}
+
+void DisplacementCache::Displacement(double &x, double &y, double &z) const
+{
+  int i, j, k, n, p;
+  double u, v, w, d[3];
+  const float *tile;
+
+  u = x;
+  v = y;
+  w = z;
+  _attr.WorldToLattice(u, v, w);
+  if ((u < 0) || (v < 0) || (w < 0) || (u > _attr._x - 1) || (v > _attr._y - 1) || (w > _attr._z - 1)) {
+    n = -1;
+  } else {
+    i = int(u) / DISPLACEMENT_CACHE_TILE;
+    j = int(v) / DISPLACEMENT_CACHE_TILE;
+    k = int(w) / DISPLACEMENT_CACHE_TILE;
+    if (i >= _nx) i = _nx - 1;
+    if (j >= _ny) j = _ny - 1;
+    if (k >= _nz) k = _nz - 1;
+    n = _frame * _numberOfFrameTiles + i + _nx * (j + _ny * k);
+  }
+
+  // Points outside the grid or in tiles which have not been required are evaluated directly
+  if ((n < 0) || (_tiles[n].empty() == true)) {
+    u = x;
+    v = y;
+    w = z;
+    if (_inverse == true) {
+      ChainDisplacement(_transformations, u, v, w, _t, _t0);
+      u = -u;
+      v = -v;
+      w = -w;
+      InverseChainDisplacement(_transformations, x, y, z, u, v, w, _t, _t0);
+    } else {
+      ChainDisplacement(_transformations, u, v, w, _t, _t0);
+    }
+    x = u;
+    y = v;
+    z = w;
+    return;
+  }
+
+  // Trilinear interpolation within the tile
+  tile = &_tiles[n][0];
+  u -= i * DISPLACEMENT_CACHE_TILE;
+  v -= j * DISPLACEMENT_CACHE_TILE;
+  w -= k * DISPLACEMENT_CACHE_TILE;
+  i = int(u);
+  j = int(v);
+  k = int(w);
+  if (i >= DISPLACEMENT_CACHE_TILE) i = DISPLACEMENT_CACHE_TILE - 1;
+  if (j >= DISPLACEMENT_CACHE_TILE) j = DISPLACEMENT_CACHE_TILE - 1;
+  if (k >= DISPLACEMENT_CACHE_TILE) k = DISPLACEMENT_CACHE_TILE - 1;
+  u -= i;
+  v -= j;
+  w -= k;
+  p = 3 * (i + DISPLACEMENT_CACHE_POINTS * (j + DISPLACEMENT_CACHE_POINTS * k));
+  for (n = 0; n < 3; n++) {
+    d[n] = (1 - w) * ((1 - v) * ((1 - u) * tile[p + n]
+                                 + u * tile[p + n + 3])
+                      + v * ((1 - u) * tile[p + n + 3 * DISPLACEMENT_CACHE_POINTS]
+                             + u * tile[p + n + 3 * DISPLACEMENT_CACHE_POINTS + 3]))
+         + w * ((1 - v) * ((1 - u) * tile[p + n + 3 * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS]
+                           + u * tile[p + n + 3 * DISPLACEMENT_CACHE_POINTS * DISPLACEMENT_CACHE_POINTS + 3])
+                + v * ((1 - u) * tile[p + n + 3 * DISPLACEMENT_CACHE_POINTS * (DISPLACEMENT_CACHE_POINTS + 1)]
+                       + u * tile[p + n + 3 * DISPLACEMENT_CACHE_POINTS * (DISPLACEMENT_CACHE_POINTS + 1) + 3]));
+  }
+  x = d[0];
+  y = d[1];
+  z = d[2];
+}
@@ -13,6 +13,7 @@
 #include <mirtk/Image.h>
 #include <mirtk/Transformation.h>
 #include <mirtk/Registration.h>
+#include <mirtk/Parallel.h>
 
 #ifdef __APPLE__
 #include <OpenGl/gl.h>
@@ -32,74 +33,249 @@
 
 #include <HistogramWindow.h>
 
+#include <algorithm>
+#include <vector>
+
+/// Accumulates global and per-label histogram bins over a range of voxels
+template <class VoxelType>
+class HistogramSampler
+{
+public:
+
+  /// Target voxels
+  const VoxelType *_target;
+
+  /// Segmentation voxels (NULL if labels are not sampled)
+  const int *_labels;
+
+  /// Number of segmentation voxels (target voxels wrap around if fewer)
+  int _numberOfLabels;
+
+  /// Histogram slot of each label up to SHRT_MAX (-1 if label is not in the table)
+  const int *_slot;
+
+  /// Label of each histogram slot in ascending order (slot 0 is the global histogram)
+  const int *_ids;
+
+  /// Number of histogram slots (slot 0 is the global histogram)
+  int _numberOfSlots;
+
+  /// Histogram used to convert intensities into bins
+  const mirtk::Histogram1D<int> *_histogram;
+
+  /// Bins of all histograms (thread local)
+  std::vector<int> _bins;
+
+  HistogramSampler() : _target(NULL), _labels(NULL), _numberOfLabels(0), _slot(NULL), _ids(NULL), _numberOfSlots(1), _histogram(NULL)
+  {
+  }
+
+  HistogramSampler(HistogramSampler &other, mirtk::split) : _target(other._target), _labels(other._labels), _numberOfLabels(other._numberOfLabels), _slot(other._slot), _ids(other._ids), _numberOfSlots(other._numberOfSlots), _histogram(other._histogram), _bins(other._bins.size(), 0)
+  {
+  }
+
+  void join(const HistogramSampler &other)
+  {
+    int i;
+
+    for (i = 0; i < int(_bins.size()); i++) {
+      _bins[i] += other._bins[i];
+    }
+  }
+
+  void operator()(const mirtk::blocked_range<int> &re)
+  {
+    int i, bin, slot, label;
+    double value;
+    const int *it;
+
+    for (i = re.begin(); i != re.end(); i++) {
+      value = _target[i];
+      if (value == 0) continue;
+      bin = _histogram->ValToBin(value);
+      if ((bin < 0) || (bin >= HISTOGRAM_BINS)) continue;
+      _bins[bin]++;
+      if (_labels != NULL) {
+        label = _labels[i % _numberOfLabels];
+        if (label < 0) continue;
+        if (label <= SHRT_MAX) {
+          slot = _slot[label];
+        } else {
+          // Labels above the direct lookup range are found among the sorted slot labels
+          it   = std::lower_bound(_ids + 1, _ids + _numberOfSlots, label);
+          slot = ((it != _ids + _numberOfSlots) && (*it == label)) ? int(it - _ids) : -1;
+        }
+        if (slot > 0) _bins[slot * HISTOGRAM_BINS + bin]++;
+      }
+    }
+  }
+};
+
+template <class VoxelType>
+static void SampleHistograms(mirtk::Image *target, const int *labels, int numberOfLabels, const int *slot, const int *ids, int numberOfSlots, const mirtk::Histogram1D<int> *histogram, std::vector<int> &bins)
+{
+  HistogramSampler<VoxelType> body;
+
+  body._target         = static_cast<const VoxelType *>(target->GetScalarPointer());
+  body._labels         = labels;
+  body._numberOfLabels = numberOfLabels;
+  body._slot           = slot;
+  body._ids            = ids;
+  body._numberOfSlots  = numberOfSlots;
+  body._histogram      = histogram;
+  body._bins.assign(numberOfSlots * HISTOGRAM_BINS, 0);
+  mirtk::parallel_reduce(mirtk::blocked_range<int>(0, target->GetNumberOfVoxels()), body);
+  bins.swap(body._bins);
+}
+
 HistogramWindow::HistogramWindow(RView  *viewer)
 {
   _v = viewer;
+  _valid = false;
+}
+
+bool HistogramWindow::SegmentationMatchesTarget()
+{
+  mirtk::Image *target = _v->GetTarget();
+  mirtk::GenericImage<int> *segmentation = _v->GetSegmentation();
+
+  if (segmentation->IsEmpty() == true) return false;
+  return ((segmentation->GetX() == target->GetX()) && (segmentation->GetY() == target->GetY()) &&
+          (segmentation->GetZ() == target->GetZ()) && ((segmentation->GetT() == 1) || (segmentation->GetT() == target->GetT())));
 }
 
 void HistogramWindow::CalculateHistograms()
 {
-  int i;
+  int i, j, id, n, numberOfSlots, numberOfLabels;
+  double min, max;
+  const int *labels;
+  mirtk::Image *target;
+  mirtk::GenericImage<int> *segmentation;
+  SegmentTable *table;
+  std::vector<int> slot, bins, ids;
 
-  if (_v->GetTarget()->IsEmpty()) {
+  _valid = false;
+  target = _v->GetTarget();
+  if (target->IsEmpty()) {
     std::cerr << "No target image loaded." << std::endl;
     return;
   }
 
-  // Calculate global histogram
-  i = -1;
-  CalculateHistogram(i);
+  // Intensity range was computed when the target was loaded
+  min = _v->GetTargetStatistics()->GetMin();
+  max = _v->GetTargetStatistics()->GetMax();
+  _globalHistogram.PutMin(min);
+  _globalHistogram.PutMax(max);
+  _globalHistogram.PutNumberOfBins(HISTOGRAM_BINS);
+  _localHistogram.clear();
+
+  // Assign a histogram slot to each non-negative label, labels of the table are in ascending order
+  table = _v->GetSegmentTable();
+  slot.assign(SHRT_MAX+1, -1);
+  ids.push_back(-1);
+  for (i = 0; i < table->NumberOfSegments(); i++) {
+    id = table->GetSegmentId(i);
+    if (id >= 0) {
+      if (id <= SHRT_MAX) slot[id] = ids.size();
+      ids.push_back(id);
+    }
+  }
+  numberOfSlots = ids.size();
+
+  // Labels are only sampled if the segmentation matches the target grid
+  labels = NULL;
+  numberOfLabels = 0;
+  segmentation = _v->GetSegmentation();
+  if ((numberOfSlots > 1) && (segmentation->IsEmpty() == false)) {
+    if (this->SegmentationMatchesTarget() == true) {
+      labels = segmentation->GetPointerToVoxels();
+      numberOfLabels = segmentation->GetNumberOfVoxels();
+    } else {
+      std::cerr << "HistogramWindow::CalculateHistograms: Segmentation does not match target image" << std::endl;
+    }
+  }
+
+  // Compute all histograms in a single pass over the target
+  switch (target->GetDataType()) {
+    case mirtk::MIRTK_VOXEL_CHAR:
+      SampleHistograms<char>(target, labels, numberOfLabels, &slot[0], &ids[0], numberOfSlots, &_globalHistogram, bins);
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_CHAR:
+      SampleHistograms<unsigned char>(target, labels, numberOfLabels, &slot[0], &ids[0], numberOfSlots, &_globalHistogram, bins);
+      break;
+    case mirtk::MIRTK_VOXEL_SHORT:
+      SampleHistograms<short>(target, labels, numberOfLabels, &slot[0], &ids[0], numberOfSlots, &_globalHistogram, bins);
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_SHORT:
+      SampleHistograms<unsigned short>(target, labels, numberOfLabels, &slot[0], &ids[0], numberOfSlots, &_globalHistogram, bins);
+      break;
+    case mirtk::MIRTK_VOXEL_INT:
+      SampleHistograms<int>(target, labels, numberOfLabels, &slot[0], &ids[0], numberOfSlots, &_globalHistogram, bins);
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_INT:
+      SampleHistograms<unsigned int>(target, labels, numberOfLabels, &slot[0], &ids[0], numberOfSlots, &_globalHistogram, bins);
+      break;
+    case mirtk::MIRTK_VOXEL_FLOAT:
+      SampleHistograms<float>(target, labels, numberOfLabels, &slot[0], &ids[0], numberOfSlots, &_globalHistogram, bins);
+      break;
+    case mirtk::MIRTK_VOXEL_DOUBLE:
+      SampleHistograms<double>(target, labels, numberOfLabels, &slot[0], &ids[0], numberOfSlots, &_globalHistogram, bins);
+      break;
+    default:
+      std::cerr << "HistogramWindow::CalculateHistograms: Unsupported voxel type" << std::endl;
+      return;
+  }
 
-  // Calculate histogram for each structure
-  for (i = 0; i < _v->GetSegmentTable()->Size(); i++) {
-    if ( _v->GetSegmentTable()->IsValid(i) == true) CalculateHistogram(i);
+  // Copy merged bins into histograms
+  for (i = 0; i < numberOfSlots; i++) {
+    mirtk::Histogram1D<int> &histogram = (i == 0) ? _globalHistogram : _localHistogram[ids[i]];
+    if (i > 0) {
+      histogram.PutMin(min);
+      histogram.PutMax(max);
+      histogram.PutNumberOfBins(HISTOGRAM_BINS);
+    }
+    for (j = 0; j < HISTOGRAM_BINS; j++) {
+      n = bins[i * HISTOGRAM_BINS + j];
+      if (n > 0) histogram.Add(j, n);
+    }
   }
+  _valid = true;
 }
 
-void HistogramWindow::CalculateHistogram(int label_id)
+void HistogramWindow::UpdateHistograms(const std::vector<LabelChange> &changes)
 {
-  int i, j, k, l;
-  double min, max;
+  int i, n, index;
   double value;
+  mirtk::Image *target;
+  SegmentTable *table;
+  std::map<int, mirtk::Histogram1D<int> >::iterator from, to;
 
-  if (_v->GetTarget()->IsEmpty()) {
-    std::cerr<< "No target image loaded." << std::endl;
-    return;
-  }
+  // Nothing to update if histograms have not been computed yet
+  if ((_valid == false) || (changes.size() == 0)) return;
+  if (this->SegmentationMatchesTarget() == false) return;
 
-  _v->GetTarget()->GetMinMaxAsDouble(&min, &max);
+  target = _v->GetTarget();
+  table  = _v->GetSegmentTable();
+  n = _v->GetSegmentation()->GetNumberOfVoxels();
 
-  if (label_id < 0) {
-    _globalHistogram.PutMin(min);
-    _globalHistogram.PutMax(max);
-    _globalHistogram.PutNumberOfBins(HISTOGRAM_BINS);
+  for (i = 0; i < int(changes.size()); i++) {
+    from = _localHistogram.find(changes[i]._old);
+    to   = _localHistogram.find(changes[i]._new);
 
-    for (l = 0; l < _v->GetTarget()->GetT(); l++){
-      for (k = 0; k < _v->GetTarget()->GetZ(); k++){
-        for (j = 0; j < _v->GetTarget()->GetY(); j++){
-          for (i = 0; i < _v->GetTarget()->GetX(); i++){
-               value = _v->GetTarget()->GetAsDouble(i, j, k, l);
-          	if (value!=0)_globalHistogram.AddSample(value);
-          }
-        }
-      }
+    // Create histogram for labels added since the last computation
+    if ((to == _localHistogram.end()) && (table->IsValid(changes[i]._new) == true)) {
+      to = _localHistogram.insert(std::make_pair(int(changes[i]._new), mirtk::Histogram1D<int>())).first;
+      to->second.PutMin(_globalHistogram.GetMin());
+      to->second.PutMax(_globalHistogram.GetMax());
+      to->second.PutNumberOfBins(HISTOGRAM_BINS);
     }
-  } else {
-    if (_v->GetSegmentTable()->IsValid(label_id) == true) {
-      _localHistogram[label_id].PutMin(min);
-      _localHistogram[label_id].PutMax(max);
-      _localHistogram[label_id].PutNumberOfBins(HISTOGRAM_BINS);
-      for (l = 0; l < _v->GetTarget()->GetT(); l++){
-        for (k = 0; k < _v->GetTarget()->GetZ(); k++){
-          for (j = 0; j < _v->GetTarget()->GetY(); j++){
-            for (i = 0; i < _v->GetTarget()->GetX(); i++){
-                value = _v->GetTarget()->GetAsDouble(i, j, k, l);
-            	if ((value!=0)&&(_v->GetSegmentation()->Get(i, j, k, l) == label_id)) _globalHistogram.AddSample(value);
-            }
-          }
-        }
-      }
+
+    // Move samples of all target frames which share the segmentation voxel
+    for (index = changes[i]._index; index < target->GetNumberOfVoxels(); index += n) {
+      value = target->GetAsDouble(index);
+      if (value == 0) continue;
+      if (from != _localHistogram.end()) from->second.DelSample(value);
+      if (to   != _localHistogram.end()) to->second.AddSample(value);
     }
   }
 }
-
@@ -0,0 +1,328 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#include <mirtk/Image.h>
+#include <mirtk/Parallel.h>
+
+#include <ImageStatistics.h>
+
+#include <cmath>
+#include <limits>
+
+/// Counts voxels of each value of an image with 8 or 16-bit integer voxels
+template <class VoxelType>
+class IntensityCount
+{
+public:
+
+  /// Image voxels
+  const VoxelType *_voxels;
+
+  /// Number of voxels of each value (thread local)
+  std::vector<int> _bins;
+
+  IntensityCount(const VoxelType *voxels) : _voxels(voxels), _bins(1 << (8 * sizeof(VoxelType)), 0)
+  {
+  }
+
+  IntensityCount(IntensityCount &other, mirtk::split) : _voxels(other._voxels), _bins(other._bins.size(), 0)
+  {
+  }
+
+  void join(const IntensityCount &other)
+  {
+    int i;
+
+    for (i = 0; i < int(_bins.size()); i++) {
+      _bins[i] += other._bins[i];
+    }
+  }
+
+  void operator()(const mirtk::blocked_range<int> &re)
+  {
+    int i;
+
+    for (i = re.begin(); i != re.end(); i++) {
+      _bins[int(_voxels[i]) - int(std::numeric_limits<VoxelType>::min())]++;
+    }
+  }
+};
+
+/// Finds minimum and maximum finite voxel value
+template <class VoxelType>
+class IntensityRange
+{
+public:
+
+  /// Image voxels
+  const VoxelType *_voxels;
+
+  /// Minimum and maximum value (thread local)
+  double _min, _max;
+
+  /// Number of finite voxels (thread local)
+  int _count;
+
+  IntensityRange(const VoxelType *voxels) : _voxels(voxels), _min(std::numeric_limits<double>::max()), _max(-std::numeric_limits<double>::max()), _count(0)
+  {
+  }
+
+  IntensityRange(IntensityRange &other, mirtk::split) : _voxels(other._voxels), _min(std::numeric_limits<double>::max()), _max(-std::numeric_limits<double>::max()), _count(0)
+  {
+  }
+
+  void join(const IntensityRange &other)
+  {
+    if (other._min < _min) _min = other._min;
+    if (other._max > _max) _max = other._max;
+    _count += other._count;
+  }
+
+  void operator()(const mirtk::blocked_range<int> &re)
+  {
+    int i;
+    double value;
+
+    for (i = re.begin(); i != re.end(); i++) {
+      value = _voxels[i];
+      if (std::isfinite(value) == false) continue;
+      if (value < _min) _min = value;
+      if (value > _max) _max = value;
+      _count++;
+    }
+  }
+};
+
+/// Bins voxel values into a histogram with equally sized bins
+template <class VoxelType>
+class IntensityBins
+{
+public:
+
+  /// Image voxels
+  const VoxelType *_voxels;
+
+  /// Lower bound and width of bins
+  double _min, _width;
+
+  /// Number of voxels in each bin (thread local)
+  std::vector<int> _bins;
+
+  /// Number of voxels below the first bin (thread local)
+  int _below;
+
+  IntensityBins(const VoxelType *voxels, double min, double width) : _voxels(voxels), _min(min), _width(width), _bins(IMAGE_STATISTICS_BINS, 0), _below(0)
+  {
+  }
+
+  IntensityBins(IntensityBins &other, mirtk::split) : _voxels(other._voxels), _min(other._min), _width(other._width), _bins(other._bins.size(), 0), _below(0)
+  {
+  }
+
+  void join(const IntensityBins &other)
+  {
+    int i;
+
+    for (i = 0; i < int(_bins.size()); i++) {
+      _bins[i] += other._bins[i];
+    }
+    _below += other._below;
+  }
+
+  void operator()(const mirtk::blocked_range<int> &re)
+  {
+    int i;
+    double bin;
+
+    for (i = re.begin(); i != re.end(); i++) {
+      if (std::isfinite(double(_voxels[i])) == false) continue;
+      bin = (_voxels[i] - _min) / _width;
+      if (bin < 0) {
+        _below++;
+      } else if (bin < IMAGE_STATISTICS_BINS) {
+        _bins[int(bin)]++;
+      } else if (bin < IMAGE_STATISTICS_BINS + 1) {
+        // Maximum intensity
+        _bins[IMAGE_STATISTICS_BINS - 1]++;
+      }
+    }
+  }
+};
+
+template <class VoxelType>
+void ImageStatistics::CountIntensities(const VoxelType *voxels, int n)
+{
+  int first, last;
+  IntensityCount<VoxelType> body(voxels);
+
+  mirtk::parallel_reduce(mirtk::blocked_range<int>(0, n), body);
+
+  // Trim histogram to range of values which occur
+  for (first = 0; body._bins[first] == 0; first++);
+  for (last = body._bins.size() - 1; body._bins[last] == 0; last--);
+  _min    = double(std::numeric_limits<VoxelType>::min()) + first;
+  _max    = double(std::numeric_limits<VoxelType>::min()) + last;
+  _binMin = _min;
+  _bins.assign(body._bins.begin() + first, body._bins.begin() + last + 1);
+  _count  = n;
+}
+
+template <class VoxelType>
+void ImageStatistics::BinIntensities(const VoxelType *voxels, int n)
+{
+  int i, first, last, sum;
+  IntensityRange<VoxelType> range(voxels);
+
+  mirtk::parallel_reduce(mirtk::blocked_range<int>(0, n), range);
+
+  // Nothing to bin if no voxel is finite
+  if (range._count == 0) return;
+  _count    = range._count;
+  _min      = range._min;
+  _max      = range._max;
+  _binMin   = range._min;
+  _binWidth = (range._max > range._min) ? (range._max - range._min) / IMAGE_STATISTICS_BINS : 1;
+
+  IntensityBins<VoxelType> coarse(voxels, _binMin, _binWidth);
+  mirtk::parallel_reduce(mirtk::blocked_range<int>(0, n), coarse);
+  _bins.swap(coarse._bins);
+
+  // Bins which contain all but the most extreme voxels
+  for (first = 0, sum = 0; (first < IMAGE_STATISTICS_BINS - 1) && (sum + _bins[first] <= _count / 10000); first++) {
+    sum += _bins[first];
+  }
+  for (last = IMAGE_STATISTICS_BINS - 1, sum = 0; (last > first) && (sum + _bins[last] <= _count / 10000); last--) {
+    sum += _bins[last];
+  }
+
+  // Resolve these bins if outliers compress them into a small part of the histogram
+  if (last - first + 1 < IMAGE_STATISTICS_BINS / 16) {
+    IntensityBins<VoxelType> fine(voxels, _binMin + first * _binWidth,
+                                  (last - first + 1) * _binWidth / IMAGE_STATISTICS_BINS);
+    mirtk::parallel_reduce(mirtk::blocked_range<int>(0, n), fine);
+    _fineMin   = fine._min;
+    _fineWidth = fine._width;
+    _fineBelow = fine._below;
+    _fineBins.swap(fine._bins);
+    for (i = 0, _fineCount = 0; i < IMAGE_STATISTICS_BINS; i++) {
+      _fineCount += _fineBins[i];
+    }
+  }
+}
+
+ImageStatistics::ImageStatistics()
+{
+  this->Clear();
+}
+
+void ImageStatistics::Clear()
+{
+  _min       = 0;
+  _max       = 0;
+  _binMin    = 0;
+  _binWidth  = 1;
+  _fineMin   = 0;
+  _fineWidth = 1;
+  _fineBelow = 0;
+  _fineCount = 0;
+  _count     = 0;
+  _bins.clear();
+  _fineBins.clear();
+}
+
+void ImageStatistics::Compute(mirtk::Image *image)
+{
+  int n;
+  void *voxels;
+
+  this->Clear();
+
+  n = image->GetNumberOfVoxels();
+  if (n == 0) return;
+  voxels = image->GetScalarPointer();
+
+  switch (image->GetDataType()) {
+    case mirtk::MIRTK_VOXEL_CHAR:
+      CountIntensities(static_cast<const char *>(voxels), n);
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_CHAR:
+      CountIntensities(static_cast<const unsigned char *>(voxels), n);
+      break;
+    case mirtk::MIRTK_VOXEL_SHORT:
+      CountIntensities(static_cast<const short *>(voxels), n);
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_SHORT:
+      CountIntensities(static_cast<const unsigned short *>(voxels), n);
+      break;
+    case mirtk::MIRTK_VOXEL_INT:
+      BinIntensities(static_cast<const int *>(voxels), n);
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_INT:
+      BinIntensities(static_cast<const unsigned int *>(voxels), n);
+      break;
+    case mirtk::MIRTK_VOXEL_FLOAT:
+      BinIntensities(static_cast<const float *>(voxels), n);
+      break;
+    case mirtk::MIRTK_VOXEL_DOUBLE:
+      BinIntensities(static_cast<const double *>(voxels), n);
+      break;
+    default:
+      // Fall back to a serial scan without histogram
+      image->GetMinMaxAsDouble(&_min, &_max);
+      return;
+  }
+}
+
+/// Interpolated value at which the cumulative count of a histogram reaches n
+static double Quantile(const std::vector<int> &bins, double min, double width, double n)
+{
+  int i;
+  double sum;
+
+  sum = 0;
+  for (i = 0; i < int(bins.size()) - 1; i++) {
+    if (sum + bins[i] >= n) break;
+    sum += bins[i];
+  }
+  if (bins[i] == 0) return min + (i + 1) * width;
+  return min + (i + (n - sum) / bins[i]) * width;
+}
+
+double ImageStatistics::Percentile(double p) const
+{
+  double n, value;
+
+  if (_count == 0) return (p < 50) ? _min : _max;
+  if (p <= 0)   return _min;
+  if (p >= 100) return _max;
+
+  // Use fine histogram if the percentile lies within its range
+  n = p / 100.0 * _count;
+  if ((_fineCount > 0) && (n > _fineBelow) && (n <= _fineBelow + _fineCount)) {
+    value = Quantile(_fineBins, _fineMin, _fineWidth, n - _fineBelow);
+  } else {
+    value = Quantile(_bins, _binMin, _binWidth, n);
+  }
+  if (value < _min) value = _min;
+  if (value > _max) value = _max;
+  return value;
+}
+
+void ImageStatistics::GetPercentileRange(double p1, double p2, double &min, double &max) const
+{
+  min = this->Percentile(p1);
+  max = this->Percentile(p2);
+  if (max <= min) {
+    min = _min;
+    max = _max;
+  }
+}
@@ -359,6 +359,118 @@ void LookupTable::SetColorModeToRainbow()
 #endif
 }
 
+/// Clamp value to [0, 1]
+static inline float clamp01(float t)
+{
+  return (t < 0) ? 0 : ((t > 1) ? 1 : t);
+}
+
+/// Color of fully saturated hue (0..1) with maximum value
+static inline void hue_to_rgb(float h, ColorRGBA &c)
+{
+  c.r = (unsigned char)(255 * clamp01(fabsf(6 * h - 3) - 1) + 0.5f);
+  c.g = (unsigned char)(255 * clamp01(2 - fabsf(6 * h - 2)) + 0.5f);
+  c.b = (unsigned char)(255 * clamp01(2 - fabsf(6 * h - 4)) + 0.5f);
+}
+
+void LookupTable::Map(const float *values, int n, double min, double max, double displayMin, double displayMax, ColorRGBA *colors)
+{
+  int i;
+  bool red, green, blue;
+  float t, lo, hi, pivot, scale;
+  unsigned char c;
+
+  // Normalize display range
+  scale = (displayMax > displayMin) ? 1.0 / (displayMax - displayMin) : 0;
+
+  // Jacobian color maps are centered at table value 100
+  pivot = min + 100 * (max - min) / 10000.0;
+
+  switch (_mode) {
+  case ColorMode_Luminance:
+  case ColorMode_InverseLuminance:
+  case ColorMode_Red:
+  case ColorMode_Green:
+  case ColorMode_Blue:
+  case ColorMode_HotMetal:
+    // Channels which follow the intensity ramp
+    red   = (_mode != ColorMode_Green) && (_mode != ColorMode_Blue) && (_mode != ColorMode_HotMetal);
+    green = (_mode != ColorMode_Red)   && (_mode != ColorMode_Blue);
+    blue  = (_mode != ColorMode_Red)   && (_mode != ColorMode_Green) && (_mode != ColorMode_HotMetal);
+    for (i = 0; i < n; i++) {
+      t = clamp01((values[i] - displayMin) * scale);
+      if (_mode == ColorMode_InverseLuminance) t = 1 - t;
+      c = (unsigned char)(255 * t + 0.5f);
+      colors[i].r = red   ? c : 0;
+      colors[i].g = green ? c : 0;
+      colors[i].b = blue  ? c : 0;
+      colors[i].a = 1;
+    }
+    if (_mode == ColorMode_HotMetal) {
+      for (i = 0; i < n; i++) {
+        colors[i].r = (values[i] < displayMin) ? 0 : 255;
+      }
+    }
+    break;
+  case ColorMode_Rainbow:
+    for (i = 0; i < n; i++) {
+      hue_to_rgb((1 - clamp01((values[i] - displayMin) * scale)) * 2.0f / 3.0f, colors[i]);
+      colors[i].a = 1;
+    }
+    break;
+  case ColorMode_Jacobian:
+    for (i = 0; i < n; i++) {
+      if (values[i] < pivot) {
+        t = (displayMin < pivot) ? clamp01((pivot - values[i]) / (pivot - displayMin)) : 1;
+        hue_to_rgb((240.0f - 60.0f * t) / 360.0f, colors[i]);
+      } else {
+        t = (displayMax > pivot) ? clamp01((values[i] - pivot) / (displayMax - pivot)) : 1;
+        hue_to_rgb(60.0f * t / 360.0f, colors[i]);
+      }
+      colors[i].a = 1;
+    }
+    break;
+  case ColorMode_JacobianExpansion:
+    lo = (displayMin > pivot) ? displayMin : pivot;
+    hi = (displayMax > pivot) ? displayMax : pivot;
+    for (i = 0; i < n; i++) {
+      if (values[i] < lo) {
+        colors[i] = 0;
+        colors[i].a = 0;
+      } else {
+        t = (hi > lo) ? clamp01((values[i] - lo) / (hi - lo)) : 1;
+        hue_to_rgb(60.0f * t / 360.0f, colors[i]);
+        colors[i].a = t;
+      }
+    }
+    break;
+  case ColorMode_JacobianContraction:
+    lo = (displayMin < pivot) ? displayMin : pivot;
+    hi = (displayMax < pivot) ? displayMax : pivot;
+    for (i = 0; i < n; i++) {
+      if (values[i] > hi) {
+        colors[i] = 0;
+        colors[i].a = 0;
+      } else {
+        t = (hi > lo) ? clamp01((hi - values[i]) / (hi - lo)) : 1;
+        hue_to_rgb((240.0f - 60.0f * t) / 360.0f, colors[i]);
+        colors[i].a = t;
+      }
+    }
+    break;
+  default:
+    // Custom tables have no analytic form, look up nearest table entry
+    scale = (max > min) ? 10000.0 / (max - min) : 0;
+    for (i = 0; i < n; i++) {
+      t = (values[i] - min) * scale;
+      if (t < _minData) t = _minData;
+      if (t > _maxData) t = _maxData;
+      colors[i] = this->At(round(t));
+    }
+    break;
+  }
+}
+
 void LookupTable::Read(char *filename)
 {
   float a;
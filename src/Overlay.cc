@@ -0,0 +1,77 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#ifdef __APPLE__
+#include <OpenGl/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include <iostream>
+
+#include <Overlay.h>
+
+Overlay::Overlay()
+{
+  _mode    = GL_LINES;
+  _keySize = 0;
+  _valid   = false;
+  _r       = 0;
+  _g       = 0;
+  _b       = 0;
+}
+
+bool Overlay::IsValid(int n, const double *key) const
+{
+  int i;
+
+  if ((_valid == false) || (n != _keySize)) return false;
+  for (i = 0; i < n; i++) {
+    if (_key[i] != key[i]) return false;
+  }
+  return true;
+}
+
+void Overlay::Begin(unsigned int mode, int n, const double *key)
+{
+  int i;
+
+  if (n > MAX_OVERLAY_KEY) {
+    std::cerr << "Overlay::Begin: Key has too many values" << std::endl;
+    n = MAX_OVERLAY_KEY;
+  }
+
+  _mode    = mode;
+  _keySize = n;
+  for (i = 0; i < n; i++) _key[i] = key[i];
+
+  // Keep the allocated memory for the new geometry
+  _vertices.clear();
+  _colors.clear();
+  _valid = true;
+}
+
+void Overlay::Draw(float x, float y) const
+{
+  if ((_valid == false) || (_vertices.size() == 0)) return;
+
+  glPushMatrix();
+  glTranslatef(x, y, 0);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(2, GL_FLOAT, 0, &_vertices[0]);
+  glColorPointer (3, GL_UNSIGNED_BYTE, 0, &_colors[0]);
+  glDrawArrays(_mode, 0, this->Size());
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glPopMatrix();
+}
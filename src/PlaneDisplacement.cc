@@ -0,0 +1,398 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#include <mirtk/Image.h>
+#include <mirtk/Transformation.h>
+#include <mirtk/HomogeneousTransformation.h>
+#include <mirtk/FreeFormTransformation.h>
+#include <mirtk/MultiLevelFreeFormTransformation.h>
+#include <mirtk/Parallel.h>
+
+#include <PlaneDisplacement.h>
+
+#include <cmath>
+
+/// Lattice coordinates below this change along a row or column of the plane are ignored
+#define PLANE_DISPLACEMENT_TOLERANCE 1e-6
+
+/// Indices and cubic B-spline weights of the four control points which influence a lattice coordinate
+struct BSplineWeights
+{
+  int    _index[4];
+  double _weight[4];
+};
+
+/// Compute control point indices and weights of a lattice coordinate, displacements are constant along
+/// the z axis of a lattice with a single plane of control points as they are evaluated by the 2D B-spline
+static void ComputeWeights(double x, int n, bool planar, BSplineWeights &w)
+{
+  int i, k;
+  double t;
+
+  if (planar == true) {
+    for (k = 0; k < 4; k++) {
+      w._index[k]  = 0;
+      w._weight[k] = (k == 0) ? 1 : 0;
+    }
+    return;
+  }
+
+  i = int(floor(x));
+  t = x - i;
+  w._weight[0] = (1 - t) * (1 - t) * (1 - t) / 6.0;
+  w._weight[1] = (3 * t * t * t - 6 * t * t + 4) / 6.0;
+  w._weight[2] = (-3 * t * t * t + 3 * t * t + 3 * t + 1) / 6.0;
+  w._weight[3] = t * t * t / 6.0;
+  for (k = 0; k < 4; k++) {
+    w._index[k] = i - 1 + k;
+    // Control points outside the lattice have zero displacement
+    if ((w._index[k] < 0) || (w._index[k] >= n)) {
+      w._index[k]  = 0;
+      w._weight[k] = 0;
+    }
+  }
+}
+
+/// Contraction of one axis of a three-dimensional array of displacements with B-spline weights
+class Contraction
+{
+public:
+
+  /// Input and output components
+  const double *_in[3];
+  double *_out[3];
+
+  /// Input and output dimensions
+  int _n[3], _m[3];
+
+  /// Axis which is contracted
+  int _d;
+
+  /// Weights of each output index along the contracted axis
+  const BSplineWeights *_weights;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int c, k, r, in, out, stride, o[3];
+    double sum;
+    const BSplineWeights *w;
+
+    stride = (_d == 0) ? 1 : ((_d == 1) ? _n[0] : _n[0] * _n[1]);
+    for (r = re.begin(); r != re.end(); r++) {
+      o[1] = r % _m[1];
+      o[2] = r / _m[1];
+      for (o[0] = 0; o[0] < _m[0]; o[0]++) {
+        w = &_weights[o[_d]];
+
+        // Input index with the contracted axis at zero
+        in  = ((_d == 0) ? 0 : o[0])
+            + ((_d == 1) ? 0 : o[1]) * _n[0]
+            + ((_d == 2) ? 0 : o[2]) * _n[0] * _n[1];
+        out = o[0] + _m[0] * r;
+        for (c = 0; c < 3; c++) {
+          sum = 0;
+          for (k = 0; k < 4; k++) {
+            sum += w->_weight[k] * _in[c][in + w->_index[k] * stride];
+          }
+          _out[c][out] = sum;
+        }
+      }
+    }
+  }
+};
+
+/// Contract one axis of a three-dimensional array of displacements in parallel
+static void Contract(std::vector<double> *components, int *n, int d, const std::vector<BSplineWeights> &weights)
+{
+  int c;
+  std::vector<double> out[3];
+  Contraction body;
+
+  body._n[0] = n[0];
+  body._n[1] = n[1];
+  body._n[2] = n[2];
+  body._m[0] = n[0];
+  body._m[1] = n[1];
+  body._m[2] = n[2];
+  body._m[d] = weights.size();
+  body._d    = d;
+  body._weights = &weights[0];
+  for (c = 0; c < 3; c++) {
+    out[c].resize(body._m[0] * body._m[1] * body._m[2]);
+    body._in[c]  = &components[c][0];
+    body._out[c] = &out[c][0];
+  }
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, body._m[1] * body._m[2]), body);
+
+  for (c = 0; c < 3; c++) {
+    components[c].swap(out[c]);
+  }
+  n[d] = body._m[d];
+}
+
+/// Interpolation of the displacements of the pixels of a plane from a tile cache
+class CachedDisplacement
+{
+public:
+
+  /// Cache with the tiles of the plane computed
+  const DisplacementCache *_cache;
+
+  /// Plane
+  const mirtk::Image *_image;
+
+  /// Displacements (output)
+  double *_dx, *_dy, *_dz;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, n;
+    double x, y, z;
+
+    for (j = re.begin(); j != re.end(); j++) {
+      n = j * _image->GetX();
+      for (i = 0; i < _image->GetX(); i++, n++) {
+        x = i;
+        y = j;
+        z = 0;
+        _image->ImageToWorld(x, y, z);
+        _cache->Displacement(x, y, z);
+        _dx[n] = x;
+        _dy[n] = y;
+        _dz[n] = z;
+      }
+    }
+  }
+};
+
+PlaneDisplacement::PlaneDisplacement()
+{
+  _x = 0;
+  _y = 0;
+}
+
+bool PlaneDisplacement::IsSupported(mirtk::Transformation *transformation)
+{
+  int l;
+  mirtk::MultiLevelFreeFormTransformation *mffd;
+  mirtk::FreeFormTransformation *ffd;
+
+  mffd = dynamic_cast<mirtk::MultiLevelFreeFormTransformation *>(transformation);
+  if (mffd != NULL) {
+    for (l = 0; l < mffd->NumberOfLevels(); l++) {
+      if (mffd->LocalTransformationIsActive(l) == false) continue;
+      if (mffd->GetLocalTransformation(l)->TypeOfClass() != mirtk::TRANSFORMATION_BSPLINE_FFD_3D) return false;
+    }
+    return true;
+  }
+  ffd = dynamic_cast<mirtk::FreeFormTransformation *>(transformation);
+  return ((ffd != NULL) && (ffd->TypeOfClass() == mirtk::TRANSFORMATION_BSPLINE_FFD_3D));
+}
+
+bool PlaneDisplacement::AddFFD(mirtk::FreeFormTransformation *ffd, mirtk::Image *image)
+{
+  int c, d, i, j, k, u, v, su, sv, n[3];
+  double x, y, z, p[3][3], a[3], b[3];
+  std::vector<int> index[3];
+  std::vector<BSplineWeights> weights[3];
+  std::vector<double> components[3];
+  BSplineWeights w;
+
+  // Lattice coordinates of pixels (0, 0), (1, 0) and (0, 1), these vary linearly across the plane
+  for (k = 0; k < 3; k++) {
+    p[k][0] = (k == 1) ? 1 : 0;
+    p[k][1] = (k == 2) ? 1 : 0;
+    p[k][2] = 0;
+    image->ImageToWorld(p[k][0], p[k][1], p[k][2]);
+    ffd->WorldToLattice(p[k][0], p[k][1], p[k][2]);
+  }
+  n[0] = ffd->GetX();
+  n[1] = ffd->GetY();
+  n[2] = ffd->GetZ();
+
+  // Each lattice axis may only vary along the rows (u) or the columns (v) of the plane
+  u = -1;
+  v = -1;
+  for (d = 0; d < 3; d++) {
+    a[d] = p[1][d] - p[0][d];
+    b[d] = p[2][d] - p[0][d];
+    if ((d == 2) && (n[2] == 1)) continue;
+    if (fabs(a[d]) * _x > PLANE_DISPLACEMENT_TOLERANCE) {
+      if ((u >= 0) || (fabs(b[d]) * _y > PLANE_DISPLACEMENT_TOLERANCE)) return false;
+      u = d;
+    } else if (fabs(b[d]) * _y > PLANE_DISPLACEMENT_TOLERANCE) {
+      if (v >= 0) return false;
+      v = d;
+    }
+  }
+
+  // Weights of each column, each row or of the whole plane along each lattice axis
+  for (d = 0; d < 3; d++) {
+    if (d == u) {
+      weights[d].resize(_x);
+      for (i = 0; i < _x; i++) ComputeWeights(p[0][d] + i * a[d], n[d], (d == 2) && (n[2] == 1), weights[d][i]);
+      for (i = 0; i < n[d]; i++) index[d].push_back(i);
+    } else if (d == v) {
+      weights[d].resize(_y);
+      for (j = 0; j < _y; j++) ComputeWeights(p[0][d] + j * b[d], n[d], (d == 2) && (n[2] == 1), weights[d][j]);
+      for (i = 0; i < n[d]; i++) index[d].push_back(i);
+    } else {
+      // Only the four control points around the plane are needed
+      ComputeWeights(p[0][d], n[d], (d == 2) && (n[2] == 1), w);
+      for (k = 0; k < 4; k++) {
+        index[d].push_back(w._index[k]);
+        w._index[k] = k;
+      }
+      weights[d].push_back(w);
+    }
+  }
+
+  // Gather the control points which influence the plane
+  for (d = 0; d < 3; d++) n[d] = index[d].size();
+  for (c = 0; c < 3; c++) components[c].resize(n[0] * n[1] * n[2]);
+  for (k = 0; k < n[2]; k++) {
+    for (j = 0; j < n[1]; j++) {
+      for (i = 0; i < n[0]; i++) {
+        ffd->Get(index[0][i], index[1][j], index[2][k], x, y, z);
+        components[0][i + n[0] * (j + n[1] * k)] = x;
+        components[1][i + n[0] * (j + n[1] * k)] = y;
+        components[2][i + n[0] * (j + n[1] * k)] = z;
+      }
+    }
+  }
+
+  // Contract the lattice axes across the plane first, then along its columns and rows,
+  // so that partial sums are shared by all pixels of a row and of a column
+  for (d = 0; d < 3; d++) {
+    if ((d != u) && (d != v)) Contract(components, n, d, weights[d]);
+  }
+  if (v >= 0) Contract(components, n, v, weights[v]);
+  if (u >= 0) Contract(components, n, u, weights[u]);
+
+  // Add displacements of the pixels
+  su = (u == 0) ? 1 : ((u == 1) ? n[0] : ((u == 2) ? n[0] * n[1] : 0));
+  sv = (v == 0) ? 1 : ((v == 1) ? n[0] : ((v == 2) ? n[0] * n[1] : 0));
+  for (j = 0; j < _y; j++) {
+    for (i = 0; i < _x; i++) {
+      _dx[i + j * _x] += components[0][i * su + j * sv];
+      _dy[i + j * _x] += components[1][i * su + j * sv];
+      _dz[i + j * _x] += components[2][i * su + j * sv];
+    }
+  }
+  return true;
+}
+
+void PlaneDisplacement::AddLinear(const mirtk::Transformation *transformation, mirtk::Image *image, bool inverse)
+{
+  int i, j, k;
+  double p[3][3], g[3][3];
+
+  // Displacements of pixels (0, 0), (1, 0) and (0, 1) determine those of the whole plane
+  for (k = 0; k < 3; k++) {
+    p[k][0] = (k == 1) ? 1 : 0;
+    p[k][1] = (k == 2) ? 1 : 0;
+    p[k][2] = 0;
+    image->ImageToWorld(p[k][0], p[k][1], p[k][2]);
+    g[k][0] = p[k][0];
+    g[k][1] = p[k][1];
+    g[k][2] = p[k][2];
+    if (inverse == true) {
+      transformation->Inverse(g[k][0], g[k][1], g[k][2]);
+    } else {
+      transformation->Transform(g[k][0], g[k][1], g[k][2]);
+    }
+    g[k][0] -= p[k][0];
+    g[k][1] -= p[k][1];
+    g[k][2] -= p[k][2];
+  }
+  for (j = 0; j < _y; j++) {
+    for (i = 0; i < _x; i++) {
+      _dx[i + j * _x] += g[0][0] + i * (g[1][0] - g[0][0]) + j * (g[2][0] - g[0][0]);
+      _dy[i + j * _x] += g[0][1] + i * (g[1][1] - g[0][1]) + j * (g[2][1] - g[0][1]);
+      _dz[i + j * _x] += g[0][2] + i * (g[1][2] - g[0][2]) + j * (g[2][2] - g[0][2]);
+    }
+  }
+}
+
+bool PlaneDisplacement::Compute(mirtk::Transformation *transformation, mirtk::Image *image)
+{
+  int l;
+  mirtk::MultiLevelFreeFormTransformation *mffd;
+  mirtk::FreeFormTransformation *ffd;
+
+  _x = image->GetX();
+  _y = image->GetY();
+  _dx.assign(_x * _y, 0);
+  _dy.assign(_x * _y, 0);
+  _dz.assign(_x * _y, 0);
+
+  mffd = dynamic_cast<mirtk::MultiLevelFreeFormTransformation *>(transformation);
+  if (mffd != NULL) {
+    // Local displacements of all active levels are added
+    for (l = 0; l < mffd->NumberOfLevels(); l++) {
+      if (mffd->LocalTransformationIsActive(l) == false) continue;
+      if (this->AddFFD(mffd->GetLocalTransformation(l), image) == false) return false;
+    }
+
+    // Displacement of the global transformation varies linearly across the plane
+    this->AddLinear(mffd->GetGlobalTransformation(), image, false);
+    return true;
+  }
+
+  ffd = dynamic_cast<mirtk::FreeFormTransformation *>(transformation);
+  if (ffd == NULL) return false;
+  return this->AddFFD(ffd, image);
+}
+
+void PlaneDisplacement::Compute(mirtk::HomogeneousTransformation *transformation, mirtk::Image *image, bool inverse)
+{
+  _x = image->GetX();
+  _y = image->GetY();
+  _dx.assign(_x * _y, 0);
+  _dy.assign(_x * _y, 0);
+  _dz.assign(_x * _y, 0);
+  this->AddLinear(transformation, image, inverse);
+}
+
+void PlaneDisplacement::Compute(DisplacementCache *cache, mirtk::Image *image, bool update)
+{
+  int i, j;
+  double x, y, z;
+  CachedDisplacement body;
+
+  _x = image->GetX();
+  _y = image->GetY();
+  _dx.resize(_x * _y);
+  _dy.resize(_x * _y);
+  _dz.resize(_x * _y);
+
+  // Only the tiles which intersect the plane are computed, others are evaluated directly
+  if (update == true) {
+    for (j = 0; j < _y; j++) {
+      for (i = 0; i < _x; i++) {
+        x = i;
+        y = j;
+        z = 0;
+        image->ImageToWorld(x, y, z);
+        cache->Require(x, y, z);
+      }
+    }
+    cache->Update();
+  }
+
+  body._cache = cache;
+  body._image = image;
+  body._dx    = &_dx[0];
+  body._dy    = &_dy[0];
+  body._dz    = &_dz[0];
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, _y), body);
+}
@@ -0,0 +1,366 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#include <mirtk/Image.h>
+#include <mirtk/Parallel.h>
+
+#include <ROIStatistics.h>
+
+#include <cmath>
+
+/// Bin index of voxels which are not finite, these are ignored
+#define ROI_STATISTICS_NOT_FINITE ROI_STATISTICS_BINS
+
+/// Summed-area table of each slice and histogram bin of each voxel
+template <class VoxelType>
+class SliceIntegral
+{
+public:
+
+  /// Voxels of the frame
+  const VoxelType *_voxels;
+
+  /// Image dimensions
+  int _x, _y;
+
+  /// Value subtracted from voxels before summation
+  double _offset;
+
+  /// Lower bound and width of histogram bins
+  double _binMin, _binWidth;
+
+  /// Summed-area tables (output)
+  double *_sum, *_sum2;
+
+  /// Histogram bins (output)
+  unsigned char *_bin;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, k, n, index, stride, bin;
+    double value, row, row2;
+    const VoxelType *ptr;
+
+    stride = _x + 1;
+    for (k = re.begin(); k != re.end(); k++) {
+      ptr = _voxels + k * _x * _y;
+      n   = k * _x * _y;
+      for (j = 0; j < _y; j++) {
+        row   = 0;
+        row2  = 0;
+        index = (k + 1) * stride * (_y + 1) + (j + 1) * stride + 1;
+        for (i = 0; i < _x; i++, ptr++, n++, index++) {
+          if (std::isfinite(double(*ptr)) == false) {
+            _sum [index] = _sum [index - stride] + row;
+            _sum2[index] = _sum2[index - stride] + row2;
+            _bin[n] = ROI_STATISTICS_NOT_FINITE;
+            continue;
+          }
+          value = *ptr - _offset;
+          row  += value;
+          row2 += value * value;
+          _sum [index] = _sum [index - stride] + row;
+          _sum2[index] = _sum2[index - stride] + row2;
+          bin = int((*ptr - _binMin) / _binWidth);
+          if (bin < 0) bin = 0;
+          if (bin >= ROI_STATISTICS_BINS) bin = ROI_STATISTICS_BINS - 1;
+          _bin[n] = bin;
+        }
+      }
+    }
+  }
+};
+
+/// Accumulation of slice tables along z
+class DepthIntegral
+{
+public:
+
+  /// Image dimensions
+  int _x, _y, _z;
+
+  /// Summed-area tables
+  double *_sum, *_sum2;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, k, index, stride, plane;
+
+    stride = _x + 1;
+    plane  = stride * (_y + 1);
+    for (j = re.begin(); j != re.end(); j++) {
+      for (k = 2; k <= _z; k++) {
+        index = k * plane + j * stride + 1;
+        for (i = 0; i < _x; i++, index++) {
+          _sum [index] += _sum [index - plane];
+          _sum2[index] += _sum2[index - plane];
+        }
+      }
+    }
+  }
+};
+
+/// Histogram of the bin indices of a box
+class BoxHistogram
+{
+public:
+
+  /// Histogram bin of each voxel
+  const unsigned char *_bin;
+
+  /// Image dimensions
+  int _x, _y;
+
+  /// Box in the x-y plane
+  int _i1, _j1, _i2, _j2;
+
+  /// Number of voxels in each bin (thread local)
+  std::vector<int> _histogram;
+
+  BoxHistogram() : _histogram(ROI_STATISTICS_BINS, 0)
+  {
+  }
+
+  BoxHistogram(BoxHistogram &other, mirtk::split) : _bin(other._bin), _x(other._x), _y(other._y),
+    _i1(other._i1), _j1(other._j1), _i2(other._i2), _j2(other._j2), _histogram(ROI_STATISTICS_BINS, 0)
+  {
+  }
+
+  void join(const BoxHistogram &other)
+  {
+    int i;
+
+    for (i = 0; i < ROI_STATISTICS_BINS; i++) {
+      _histogram[i] += other._histogram[i];
+    }
+  }
+
+  void operator()(const mirtk::blocked_range<int> &re)
+  {
+    int i, j, k;
+    const unsigned char *ptr;
+
+    for (k = re.begin(); k != re.end(); k++) {
+      for (j = _j1; j <= _j2; j++) {
+        ptr = _bin + (k * _y + j) * _x + _i1;
+        for (i = _i1; i <= _i2; i++, ptr++) {
+          if (*ptr != ROI_STATISTICS_NOT_FINITE) _histogram[*ptr]++;
+        }
+      }
+    }
+  }
+};
+
+template <class VoxelType>
+void ROIStatistics::Integrate(const VoxelType *voxels)
+{
+  SliceIntegral<VoxelType> slices;
+  slices._voxels   = voxels;
+  slices._x        = _x;
+  slices._y        = _y;
+  slices._offset   = _offset;
+  slices._binMin   = _binMin;
+  slices._binWidth = _binWidth;
+  slices._sum      = &_sum[0];
+  slices._sum2     = &_sum2[0];
+  slices._bin      = &_bin[0];
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, _z), slices);
+
+  DepthIntegral depth;
+  depth._x    = _x;
+  depth._y    = _y;
+  depth._z    = _z;
+  depth._sum  = &_sum[0];
+  depth._sum2 = &_sum2[0];
+  mirtk::parallel_for(mirtk::blocked_range<int>(1, _y + 1), depth);
+}
+
+ROIStatistics::ROIStatistics()
+{
+  this->Clear();
+}
+
+void ROIStatistics::Clear()
+{
+  _image    = NULL;
+  _frame    = -1;
+  _x        = 0;
+  _y        = 0;
+  _z        = 0;
+  _offset   = 0;
+  _binMin   = 0;
+  _binWidth = 1;
+  _i1       = -1;
+  _j1       = -1;
+  _k1       = -1;
+  _i2       = -1;
+  _j2       = -1;
+  _k2       = -1;
+  _count    = 0;
+  _mean     = 0;
+  _sigma    = 0;
+  _histogram.assign(ROI_STATISTICS_BINS, 0);
+  std::vector<double>().swap(_sum);
+  std::vector<double>().swap(_sum2);
+  std::vector<unsigned char>().swap(_bin);
+}
+
+void ROIStatistics::Initialize(mirtk::Image *image, int frame, double min, double max)
+{
+  int n;
+  void *voxels;
+
+  if ((image == _image) && (frame == _frame)) return;
+  this->Clear();
+
+  if ((frame < 0) || (frame >= image->GetT())) return;
+  n = image->GetX() * image->GetY() * image->GetZ();
+  if (n == 0) return;
+
+  _x        = image->GetX();
+  _y        = image->GetY();
+  _z        = image->GetZ();
+  _offset   = (min + max) / 2.0;
+  _binMin   = min;
+  _binWidth = (max > min) ? (max - min) / ROI_STATISTICS_BINS : 1;
+  _sum .assign((_x + 1) * (_y + 1) * (_z + 1), 0);
+  _sum2.assign((_x + 1) * (_y + 1) * (_z + 1), 0);
+  _bin .resize(n);
+
+  voxels = image->GetScalarPointer(0, 0, 0, frame);
+  switch (image->GetDataType()) {
+    case mirtk::MIRTK_VOXEL_CHAR:
+      Integrate(static_cast<const char *>(voxels));
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_CHAR:
+      Integrate(static_cast<const unsigned char *>(voxels));
+      break;
+    case mirtk::MIRTK_VOXEL_SHORT:
+      Integrate(static_cast<const short *>(voxels));
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_SHORT:
+      Integrate(static_cast<const unsigned short *>(voxels));
+      break;
+    case mirtk::MIRTK_VOXEL_INT:
+      Integrate(static_cast<const int *>(voxels));
+      break;
+    case mirtk::MIRTK_VOXEL_UNSIGNED_INT:
+      Integrate(static_cast<const unsigned int *>(voxels));
+      break;
+    case mirtk::MIRTK_VOXEL_FLOAT:
+      Integrate(static_cast<const float *>(voxels));
+      break;
+    case mirtk::MIRTK_VOXEL_DOUBLE:
+      Integrate(static_cast<const double *>(voxels));
+      break;
+    default:
+      std::cerr << "ROIStatistics::Initialize: Unsupported voxel type" << std::endl;
+      this->Clear();
+      return;
+  }
+  _image = image;
+  _frame = frame;
+}
+
+double ROIStatistics::BoxSum(const std::vector<double> &table) const
+{
+  int stride, plane, i1, i2, j1, j2, k1, k2;
+
+  stride = _x + 1;
+  plane  = stride * (_y + 1);
+  i1 = _i1;
+  i2 = _i2 + 1;
+  j1 = _j1 * stride;
+  j2 = (_j2 + 1) * stride;
+  k1 = _k1 * plane;
+  k2 = (_k2 + 1) * plane;
+  return table[k2 + j2 + i2] - table[k2 + j2 + i1] - table[k2 + j1 + i2] + table[k2 + j1 + i1]
+       - table[k1 + j2 + i2] + table[k1 + j2 + i1] + table[k1 + j1 + i2] - table[k1 + j1 + i1];
+}
+
+void ROIStatistics::Compute(int i1, int j1, int k1, int i2, int j2, int k2)
+{
+  int i;
+  double sum, sum2;
+
+  if (_image == NULL) return;
+
+  // Clamp box to image
+  if (i1 < 0) i1 = 0;
+  if (j1 < 0) j1 = 0;
+  if (k1 < 0) k1 = 0;
+  if (i2 >= _x) i2 = _x - 1;
+  if (j2 >= _y) j2 = _y - 1;
+  if (k2 >= _z) k2 = _z - 1;
+
+  // Statistics of the same box are still valid
+  if ((i1 == _i1) && (j1 == _j1) && (k1 == _k1) && (i2 == _i2) && (j2 == _j2) && (k2 == _k2)) return;
+  _i1 = i1;
+  _j1 = j1;
+  _k1 = k1;
+  _i2 = i2;
+  _j2 = j2;
+  _k2 = k2;
+
+  if ((i2 < i1) || (j2 < j1) || (k2 < k1)) {
+    _count = 0;
+    _mean  = 0;
+    _sigma = 0;
+    _histogram.assign(ROI_STATISTICS_BINS, 0);
+    return;
+  }
+
+  // Histogram from the cached bin indices, voxels which are not finite are not counted
+  BoxHistogram body;
+  body._bin = &_bin[0];
+  body._x   = _x;
+  body._y   = _y;
+  body._i1  = i1;
+  body._j1  = j1;
+  body._i2  = i2;
+  body._j2  = j2;
+  mirtk::parallel_reduce(mirtk::blocked_range<int>(k1, k2 + 1), body);
+  _histogram.swap(body._histogram);
+  _count = 0;
+  for (i = 0; i < ROI_STATISTICS_BINS; i++) _count += _histogram[i];
+
+  // Mean and standard deviation from the summed-area tables
+  if (_count == 0) {
+    _mean  = 0;
+    _sigma = 0;
+    return;
+  }
+  sum    = this->BoxSum(_sum)  / _count;
+  sum2   = this->BoxSum(_sum2) / _count;
+  _mean  = _offset + sum;
+  _sigma = (sum2 > sum * sum) ? sqrt(sum2 - sum * sum) : 0;
+}
+
+double ROIStatistics::Percentile(double p) const
+{
+  int i;
+  double n, sum;
+
+  if (_count == 0) return 0;
+  if (p < 0)   p = 0;
+  if (p > 100) p = 100;
+
+  // Interpolate within the bin in which the cumulative count reaches n
+  n   = p / 100.0 * _count;
+  sum = 0;
+  for (i = 0; i < ROI_STATISTICS_BINS - 1; i++) {
+    if ((_histogram[i] > 0) && (sum + _histogram[i] >= n)) break;
+    sum += _histogram[i];
+  }
+  if (_histogram[i] == 0) return this->BinToValue(i + 1);
+  return _binMin + (i + (n - sum) / _histogram[i]) * _binWidth;
+}
@@ -14,6 +14,7 @@
 #include <mirtk/Registration.h>
 //#include <mirtk/PointRegistration.h>
 #include <mirtk/Transformations.h>
+#include <mirtk/Parallel.h>
 
 #ifdef __APPLE__
 #include <OpenGl/gl.h>
@@ -85,6 +86,13 @@ RView::RView(int x, int y)
   // Default: Enable caching if required by transformation
   _CacheDisplacements = true;
 
+  // Default: Cache displacements only where they are displayed
+  _PrecomputeDisplacements = false;
+  _sourceInverseCache.SetInverse(true);
+
+  // Default: Images are resliced into lookup table indices
+  _FloatDisplay = false;
+
   // Default: No isolines
   _DisplayTargetContour = false;
   _DisplaySourceContour = false;
@@ -92,6 +100,9 @@ RView::RView(int x, int y)
   // Default: Line Thickness
   _LineThickness = 2;
 
+  // Default: Single iso-level at min. display intensity
+  _IsolineLevels = 1;
+
   // Default: Speed
   _Speed = 1;
 
@@ -140,11 +151,23 @@ RView::RView(int x, int y)
 
   // Default: No viewers
   _NoOfViewers = 0;
+  _NoOfViewersAllocated = 0;
 
   // Default: No update needed
   _targetUpdate = false;
   _sourceUpdate = false;
 
+  // Default: No resliced outputs yet
+  _targetOutputVersion = 0;
+  _sourceOutputVersion = 0;
+  _segmentationOutputVersion = 0;
+
+  // Default: No cached info transformations
+  _infoX = _infoY = _infoZ = 0;
+  _infoTS = _infoTT = 0;
+  _infoSourceValid = false;
+  _infoSegmentationValid = false;
+
 #ifdef HAS_SEGMENTATION_PANEL
   _segmentationUpdate = false;
   _selectionUpdate = false;
@@ -170,7 +193,7 @@ RView::RView(int x, int y)
   _sourceImage = new mirtk::GreyImage;
 
   // Allocate memory for segmentation
-  _segmentationImage = new mirtk::GreyImage;
+  _segmentationImage = new mirtk::GenericImage<int>;
 
   // Allocate memory for segment Table
   _segmentTable = new SegmentTable();
@@ -182,6 +205,7 @@ RView::RView(int x, int y)
   _sourceTransform = new mirtk::AffineTransformation;
   _segmentationTransform = new mirtk::AffineTransformation;
   _selectionTransform = new mirtk::AffineTransformation;
+  _sourceTransformVersion = 0;
 
   // Flag whether transform shoule be applied
   _sourceTransformApply = true;
@@ -194,10 +218,16 @@ RView::RView(int x, int y)
   _targetMax = 1;
   _sourceMin = 0;
   _sourceMax = 1;
+  _targetDomainMin = 0;
+  _targetDomainMax = 1;
+  _sourceDomainMin = 0;
+  _sourceDomainMax = 1;
   _subtractionMin = 0;
   _subtractionMax = 1;
   _targetDisplayMin = 0;
   _targetDisplayMax = 1;
+  _AutoWindowMin = 0.5;
+  _AutoWindowMax = 99.5;
   _sourceDisplayMin = 0;
   _sourceDisplayMax = 1;
   _subtractionDisplayMin = 0;
@@ -229,23 +259,484 @@ RView::~RView()
 #endif
 }
 
+/// Map float reslice output onto lookup table indices of the quantized output, values are clamped
+/// to 0..SHRT_MAX such that -1 is reserved for pixels outside the image
+static void QuantizeOutput(mirtk::GenericImage<float> *input, mirtk::GreyImage *output, double min, double max)
+{
+  int i, n;
+  double scale, value;
+  const float *ptr1;
+  mirtk::GreyPixel *ptr2;
+
+  n     = input->GetNumberOfVoxels();
+  ptr1  = input->GetPointerToVoxels();
+  ptr2  = output->GetPointerToVoxels();
+  scale = (max > min) ? 10000.0 / (max - min) : 0;
+  for (i = 0; i < n; i++) {
+    if (ptr1[i] == FLOAT_PADDING_VALUE) {
+      ptr2[i] = -1;
+    } else {
+      value = (ptr1[i] - min) * scale;
+      if (value < 0) value = 0;
+      if (value > SHRT_MAX) value = SHRT_MAX;
+      ptr2[i] = round(value);
+    }
+  }
+}
+
+void RView::FloatDisplayOn()
+{
+  _FloatDisplay = true;
+  this->Initialize(false);
+}
+
+void RView::FloatDisplayOff()
+{
+  _FloatDisplay = false;
+  this->Initialize(false);
+}
+
+/// Reslice rows of a viewer output at pixels displaced by precomputed plane displacements
+template <class VoxelType>
+class DisplacedReslice
+{
+public:
+
+  /// Source image and its interpolator
+  mirtk::Image *_image;
+  mirtk::InterpolateImageFunction *_interpolator;
+
+  /// B-spline coefficients of the source frame which replace the interpolator (NULL if not used)
+  const float *_coefficients;
+
+  /// Tabulated sinc interpolation of the source frame which replaces the interpolator (NULL if not used)
+  const SincInterpolation *_sinc;
+
+  /// Viewer output
+  mirtk::GenericImage<VoxelType> *_output;
+
+  /// Displacements of the output pixels (NULL if not displaced)
+  const PlaneDisplacement *_displacement;
+
+  /// Source frame
+  int _frame;
+
+  /// Scaling of interpolated values and value outside the source
+  double _scale, _offset, _padding;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, n;
+    double x, y, z;
+    VoxelType *ptr;
+
+    for (j = re.begin(); j != re.end(); j++) {
+      n   = j * _output->GetX();
+      ptr = _output->GetPointerToVoxels(0, j, 0);
+      for (i = 0; i < _output->GetX(); i++, n++, ptr++) {
+        x = i;
+        y = j;
+        z = 0;
+        _output->ImageToWorld(x, y, z);
+        if (_displacement != NULL) {
+          x += _displacement->GetDX()[n];
+          y += _displacement->GetDY()[n];
+          z += _displacement->GetDZ()[n];
+        }
+        _image->WorldToImage(x, y, z);
+        if (_coefficients != NULL) {
+          if (SplineCoefficientCache::IsInside(_image->GetX(), _image->GetY(), _image->GetZ(), x, y, z)) {
+            *ptr = mirtk::voxel_cast<VoxelType>(_scale * SplineCoefficientCache::Evaluate(_coefficients, _image->GetX(), _image->GetY(), _image->GetZ(), x, y, z) + _offset);
+          } else {
+            *ptr = mirtk::voxel_cast<VoxelType>(_padding);
+          }
+        } else if (_sinc != NULL) {
+          if (_sinc->IsInside(x, y, z)) {
+            *ptr = mirtk::voxel_cast<VoxelType>(_scale * _sinc->Evaluate(x, y, z) + _offset);
+          } else {
+            *ptr = mirtk::voxel_cast<VoxelType>(_padding);
+          }
+        } else if (_interpolator->IsInside(x, y, z)) {
+          *ptr = mirtk::voxel_cast<VoxelType>(_scale * _interpolator->Evaluate(x, y, z, _frame) + _offset);
+        } else {
+          *ptr = mirtk::voxel_cast<VoxelType>(_padding);
+        }
+      }
+    }
+  }
+};
+
+/// Reslice a viewer output into float intensities and lookup table indices
+static void ResliceOutput(mirtk::Image *image, mirtk::InterpolateImageFunction *interpolator, const float *coefficients,
+                          const SincInterpolation *sinc, const PlaneDisplacement *displacement, int frame,
+                          mirtk::GreyImage *output, mirtk::GenericImage<float> *outputFloat, double min, double max)
+{
+  int i, n;
+  float *ptr;
+  std::vector<double> values;
+
+  outputFloat->PutOrigin(output->GetOrigin());
+
+  // Planes aligned with the image axes are interpolated separably by the sinc kernel
+  if ((sinc != NULL) && (displacement == NULL) && (sinc->ReslicePlane(output, values, FLOAT_PADDING_VALUE) == true)) {
+    n   = output->GetX() * output->GetY();
+    ptr = outputFloat->GetPointerToVoxels();
+    for (i = 0; i < n; i++) ptr[i] = values[i];
+  } else {
+    DisplacedReslice<float> body;
+    body._image        = image;
+    body._interpolator = interpolator;
+    body._coefficients = coefficients;
+    body._sinc         = sinc;
+    body._output       = outputFloat;
+    body._displacement = displacement;
+    body._frame        = frame;
+    body._scale        = 1;
+    body._offset       = 0;
+    body._padding      = FLOAT_PADDING_VALUE;
+    mirtk::parallel_for(mirtk::blocked_range<int>(0, outputFloat->GetY()), body);
+  }
+  QuantizeOutput(outputFloat, output, min, max);
+}
+
+bool RView::InitializeDisplacementCache(bool inverse)
+{
+  unsigned int i;
+  mirtk::ImageAttributes attr;
+  std::vector<mirtk::Transformation *> chain;
+  DisplacementCache *cache;
+
+  cache = (inverse == true) ? &_sourceInverseCache : &_sourceDisplacementCache;
+  if ((_sourceImage->IsEmpty() == true) || (_sourceTransform == NULL)) {
+    cache->Clear();
+    return false;
+  }
+
+  // Chains are always composed into the cache, single transformations only if they are expensive
+  // or vary over the frames, inverses of all but linear transformations which are inverted exactly
+  if (_sourceTransformChain.empty() == true) {
+    if (inverse == true) {
+      if (dynamic_cast<mirtk::HomogeneousTransformation *>(_sourceTransform) != NULL) {
+        cache->Clear();
+        return false;
+      }
+    } else if ((_CacheDisplacements != true) || ((_sourceTransform->RequiresCachingOfDisplacements() != true) &&
+                                                 (DisplacementCache::IsTimeVarying(_sourceTransform) != true))) {
+      cache->Clear();
+      return false;
+    }
+    chain.push_back(_sourceTransform);
+  } else {
+    for (i = 0; i < _sourceTransformChain.size(); i++) {
+      chain.push_back((_sourceTransformChain[i] != NULL) ? _sourceTransformChain[i] : _sourceTransform);
+    }
+  }
+
+  if (_targetImage->IsEmpty() != true) {
+    attr = _targetImage->GetImageAttributes();
+  } else {
+    attr = _sourceImage->GetImageAttributes();
+  }
+  attr._t = 1;
+  cache->Initialize(chain, _sourceTransformVersion, attr,
+                    _sourceImage->ImageToTime(_sourceFrame), _targetImage->ImageToTime(_targetFrame));
+  return true;
+}
+
+void RView::Transform(double &x, double &y, double &z)
+{
+  // Chains are only evaluated through their composed displacements, as for reslicing
+  if ((_sourceTransformChain.empty() != true) && (this->InitializeDisplacementCache() == true)) {
+    _sourceDisplacementCache.Transform(x, y, z);
+  } else {
+    _sourceTransform->Transform(x, y, z, _sourceImage->ImageToTime(_sourceFrame), _targetImage->ImageToTime(_targetFrame));
+  }
+}
+
+void RView::InverseTransform(double &x, double &y, double &z)
+{
+  // Inverses of chains and of all but linear transformations use the cached inverse where it has been computed
+  if (this->InitializeDisplacementCache(true) == true) {
+    _sourceInverseCache.Transform(x, y, z);
+  } else {
+    _sourceTransform->Inverse(x, y, z, _sourceImage->ImageToTime(_sourceFrame), _targetImage->ImageToTime(_targetFrame));
+  }
+}
+
+bool RView::GetInverseError(double &mean, double &max)
+{
+  if (_sourceInverseCache.GetNumberOfTiles() == 0) return false;
+  return _sourceInverseCache.GetInverseError(mean, max);
+}
+
+void RView::ReadTransformationChain(int n, char **names, int selected)
+{
+  int i;
+
+  this->ClearTransformationChain();
+  for (i = 0; i < n; i++) {
+    if (i == selected) {
+      // Source transformation takes this position so that it can still be edited
+      _sourceTransformChain.push_back(NULL);
+    } else {
+      _sourceTransformChain.push_back(mirtk::Transformation::New(names[i]));
+    }
+  }
+}
+
+void RView::ClearTransformationChain()
+{
+  unsigned int i;
+
+  for (i = 0; i < _sourceTransformChain.size(); i++) {
+    if (_sourceTransformChain[i] != NULL) delete _sourceTransformChain[i];
+  }
+  _sourceTransformChain.clear();
+  _sourceTransformVersion++;
+  _sourceUpdate = true;
+}
+
+bool RView::PrecomputeDisplacements()
+{
+  int i, n, s, t;
+  DisplacementCache *cache;
+
+  if ((_PrecomputeDisplacements != true) || (_sourceTransformApply != true)) return false;
+
+  // Inverse displacements are always cached, transformations which are evaluated separably are not
+  if (_sourceTransformInvert == true) {
+    if (this->InitializeDisplacementCache(true) != true) return false;
+    cache = &_sourceInverseCache;
+  } else {
+    if ((_sourceTransformChain.empty() == true) && (PlaneDisplacement::IsSupported(_sourceTransform) == true)) return false;
+    if (this->InitializeDisplacementCache() != true) return false;
+    cache = &_sourceDisplacementCache;
+  }
+
+  // Displayed planes of the frames which follow during playback come first, as many as fit into memory
+  n = cache->GetFrameCapacity() - 1;
+  if (n > _targetImage->GetT() - 1) n = _targetImage->GetT() - 1;
+  for (i = 1; i <= n; i++) {
+    t = (_targetFrame + i) % _targetImage->GetT();
+    s = (_sourceFrame + i) % _sourceImage->GetT();
+    if (cache->PrecomputeFrame(_sourceImage->ImageToTime(s), _targetImage->ImageToTime(t)) == true) return true;
+  }
+  return cache->Precompute(_origin_x, _origin_y, _origin_z);
+}
+
+bool RView::ResliceTarget(int l)
+{
+  const float *coefficients;
+  const SincInterpolation *sinc;
+
+  // Other interpolation modes are evaluated by the transformation filter
+  coefficients = NULL;
+  sinc = NULL;
+  if (this->GetTargetInterpolationMode() == mirtk::Interpolation_BSpline) {
+    coefficients = _targetCoefficients.GetCoefficients(_targetImage, _targetFrame);
+  } else if (this->GetTargetInterpolationMode() == mirtk::Interpolation_Sinc) {
+    _targetSinc.Initialize(_targetImage, _targetFrame);
+    sinc = &_targetSinc;
+  } else {
+    return false;
+  }
+
+  ResliceOutput(_targetImage, _targetInterpolator, coefficients, sinc, NULL, _targetFrame,
+                _targetImageOutput[l], _targetImageOutputFloat[l], _targetDomainMin, _targetDomainMax);
+  return true;
+}
+
+bool RView::ResliceSource(int l)
+{
+  const float *coefficients;
+  const SincInterpolation *sinc;
+  const PlaneDisplacement *displacement;
+  mirtk::HomogeneousTransformation *linear;
+
+  // Prefiltered B-spline coefficients of the frame are reused instead of initializing the interpolator again,
+  // sinc weights are tabulated instead of evaluating trigonometric functions for each sample
+  coefficients = NULL;
+  sinc = NULL;
+  if (this->GetSourceInterpolationMode() == mirtk::Interpolation_BSpline) {
+    coefficients = _sourceCoefficients.GetCoefficients(_sourceImage, _sourceFrame);
+  } else if (this->GetSourceInterpolationMode() == mirtk::Interpolation_Sinc) {
+    _sourceSinc.Initialize(_sourceImage, _sourceFrame);
+    sinc = &_sourceSinc;
+  }
+
+  if (_sourceTransformApply != true) {
+    if ((coefficients == NULL) && (sinc == NULL)) return false;
+    ResliceOutput(_sourceImage, _sourceInterpolator, coefficients, sinc, NULL, _sourceFrame,
+                  _sourceImageOutput[l], _sourceImageOutputFloat[l], _sourceDomainMin, _sourceDomainMax);
+    return true;
+  }
+
+  // Displacements of linear transformations and of their exact inverses vary linearly across the plane,
+  // interpolate inverse displacements of others from the dense inverse field instead of inverting at each pixel,
+  // evaluate B-spline FFDs separably, otherwise interpolate displacements of chains and of
+  // transformations which are expensive to evaluate from the tiles of the displacement cache
+  linear = NULL;
+  displacement = &_sourcePlaneDisplacement;
+  if (_sourceTransformChain.empty() == true) linear = dynamic_cast<mirtk::HomogeneousTransformation *>(_sourceTransform);
+  if ((linear != NULL) && (linear->IsIdentity() == true)) {
+    // Planes aligned with the image axes are then interpolated separably by the sinc kernel
+    displacement = NULL;
+  } else if (linear != NULL) {
+    _sourcePlaneDisplacement.Compute(linear, _sourceImageOutput[l], _sourceTransformInvert);
+  } else if (_sourceTransformInvert == true) {
+    if (this->InitializeDisplacementCache(true) != true) return false;
+    _sourcePlaneDisplacement.Compute(&_sourceInverseCache, _sourceImageOutput[l], _PrecomputeDisplacements != true);
+  } else if ((_sourceTransformChain.empty() != true) || (PlaneDisplacement::IsSupported(_sourceTransform) != true) ||
+      (_sourcePlaneDisplacement.Compute(_sourceTransform, _sourceImageOutput[l]) != true)) {
+    if (this->InitializeDisplacementCache() != true) return false;
+
+    // Tiles which are not ready yet are evaluated directly while they are precomputed
+    _sourcePlaneDisplacement.Compute(&_sourceDisplacementCache, _sourceImageOutput[l], _PrecomputeDisplacements != true);
+  }
+
+  if ((coefficients == NULL) && (sinc == NULL)) {
+    _sourceInterpolator->Input(_sourceImage);
+    _sourceInterpolator->Initialize();
+  }
+  ResliceOutput(_sourceImage, _sourceInterpolator, coefficients, sinc, displacement, _sourceFrame,
+                _sourceImageOutput[l], _sourceImageOutputFloat[l], _sourceDomainMin, _sourceDomainMax);
+  return true;
+}
+
+void RView::UpdateDrawableFloat(int k)
+{
+  int i, j, width, height;
+  float a;
+  double blendA, blendB;
+  double min1, max1, displayMin1, displayMax1;
+  double min2, max2, displayMin2, displayMax2;
+  const float *ptr1, *ptr2;
+  Color *ptr3;
+  LookupTable *lut1, *lut2;
+  std::vector<ColorRGBA> color1, color2;
+  std::vector<float> difference;
+
+  width  = _viewer[k]->GetWidth();
+  height = _viewer[k]->GetHeight();
+  color1.resize(width);
+  color2.resize(width);
+  difference.resize(width);
+
+  ptr1 = _targetImageOutputFloat[k]->GetPointerToVoxels();
+  ptr2 = _sourceImageOutputFloat[k]->GetPointerToVoxels();
+  ptr3 = _drawable[k];
+  lut1 = _targetLookupTable;
+  lut2 = _sourceLookupTable;
+  min1 = _targetDomainMin;
+  max1 = _targetDomainMax;
+  min2 = _sourceDomainMin;
+  max2 = _sourceDomainMax;
+  displayMin1 = _targetDisplayMin;
+  displayMax1 = _targetDisplayMax;
+  displayMin2 = _sourceDisplayMin;
+  displayMax2 = _sourceDisplayMax;
+
+  if (_isSourceViewer[k]) {
+    std::swap(ptr1, ptr2);
+    std::swap(lut1, lut2);
+    std::swap(min1, min2);
+    std::swap(max1, max2);
+    std::swap(displayMin1, displayMin2);
+    std::swap(displayMax1, displayMax2);
+  }
+
+  blendA = _viewMix;
+  blendB = 1 - blendA;
+
+  for (j = 0; j < height; j++) {
+    switch (_viewMode) {
+      case View_A:
+        lut1->Map(ptr1, width, min1, max1, displayMin1, displayMax1, &color1[0]);
+        for (i = 0; i < width; i++) ptr3[i] = color1[i];
+        break;
+      case View_B:
+        lut2->Map(ptr2, width, min2, max2, displayMin2, displayMax2, &color2[0]);
+        for (i = 0; i < width; i++) ptr3[i] = color2[i];
+        break;
+      case View_Subtraction:
+        for (i = 0; i < width; i++) {
+          difference[i] = ptr1[i] - ptr2[i];
+        }
+        _subtractionLookupTable->Map(&difference[0], width, _subtractionMin, _subtractionMax,
+                                     _subtractionDisplayMin, _subtractionDisplayMax, &color1[0]);
+        for (i = 0; i < width; i++) {
+          if ((ptr1[i] != FLOAT_PADDING_VALUE) && (ptr2[i] != FLOAT_PADDING_VALUE)) {
+            ptr3[i] = color1[i];
+          } else {
+            ptr3[i] = Color();
+          }
+        }
+        break;
+      default:
+        lut1->Map(ptr1, width, min1, max1, displayMin1, displayMax1, &color1[0]);
+        lut2->Map(ptr2, width, min2, max2, displayMin2, displayMax2, &color2[0]);
+        for (i = 0; i < width; i++) {
+          switch (_viewMode) {
+            case View_VShutter:
+              ptr3[i] = (i < _viewMix * width) ? color1[i] : color2[i];
+              break;
+            case View_HShutter:
+              ptr3[i] = (j < _viewMix * height) ? color1[i] : color2[i];
+              break;
+            case View_Checkerboard:
+              ptr3[i].r = int(blendA * color1[i].r + blendB * color2[i].r);
+              ptr3[i].g = int(blendA * color1[i].g + blendB * color2[i].g);
+              ptr3[i].b = int(blendA * color1[i].b + blendB * color2[i].b);
+              break;
+            case View_AoverB:
+              a = color1[i].a;
+              ptr3[i].r = int(a * color1[i].r + (1 - a) * color2[i].r);
+              ptr3[i].g = int(a * color1[i].g + (1 - a) * color2[i].g);
+              ptr3[i].b = int(a * color1[i].b + (1 - a) * color2[i].b);
+              break;
+            case View_BoverA:
+              a = color2[i].a;
+              ptr3[i].r = int((1 - a) * color1[i].r + a * color2[i].r);
+              ptr3[i].g = int((1 - a) * color1[i].g + a * color2[i].g);
+              ptr3[i].b = int((1 - a) * color1[i].b + a * color2[i].b);
+              break;
+            default:
+              break;
+          }
+        }
+        break;
+    }
+    ptr1 += width;
+    ptr2 += width;
+    ptr3 += width;
+  }
+}
+
 void RView::Update()
 {
   int i, j, k, l;
   double blendA, blendB;
+  unsigned int alpha;
+  const SegmentDisplay *display;
   Color *ptr3;
-  mirtk::GreyPixel *ptr1, *ptr2, *ptr4, *ptr5;
+  mirtk::GreyPixel *ptr1, *ptr2, *ptr5;
+  int *ptr4;
   LookupTable *lut1, *lut2;
 
   // Check whether target and/or source and/or segmentation need updating
   for (l = 0; l < _NoOfViewers; l++) {
-    if ((_targetUpdate == true) && (_targetImage->IsEmpty() != true)) {
-      _targetTransformFilter[l]->SourcePaddingValue(-1);
+    // Original intensities are resliced and then clamped onto the lookup table indices
+    if ((_targetUpdate == true) && (_targetImage->IsEmpty() != true) && (this->ResliceTarget(l) != true)) {
+      _targetImageOutputFloat[l]->PutOrigin(_targetImageOutput[l]->GetOrigin());
+      _targetTransformFilter[l]->SourcePaddingValue(FLOAT_PADDING_VALUE);
       _targetTransformFilter[l]->Run();
+      QuantizeOutput(_targetImageOutputFloat[l], _targetImageOutput[l], _targetDomainMin, _targetDomainMax);
     }
-    if ((_sourceUpdate == true) && (_sourceImage->IsEmpty() != true)) {
-      _sourceTransformFilter[l]->SourcePaddingValue(-1);
+    if ((_sourceUpdate == true) && (_sourceImage->IsEmpty() != true) && (this->ResliceSource(l) != true)) {
+      _sourceImageOutputFloat[l]->PutOrigin(_sourceImageOutput[l]->GetOrigin());
+      _sourceTransformFilter[l]->SourcePaddingValue(FLOAT_PADDING_VALUE);
       _sourceTransformFilter[l]->Run();
+      QuantizeOutput(_sourceImageOutputFloat[l], _sourceImageOutput[l], _sourceDomainMin, _sourceDomainMax);
     }
     if ((_segmentationUpdate == true) && (_segmentationImage->IsEmpty() != true)) {
       _segmentationTransformFilter[l]->Run();
@@ -255,6 +746,15 @@ void RView::Update()
     }
   }
 
+  // Outputs have been resliced, retained overlays need to be rebuilt
+  if (_targetUpdate == true) _targetOutputVersion++;
+  if (_sourceUpdate == true) _sourceOutputVersion++;
+  if (_segmentationUpdate == true) _segmentationOutputVersion++;
+
+  // Transformations may have changed, discard cached info transformations
+  if (_sourceUpdate == true) _infoSourceValid = false;
+  if (_segmentationUpdate == true) _infoSegmentationValid = false;
+
   // No more updating required
   _targetUpdate = false;
   _sourceUpdate = false;
@@ -270,144 +770,152 @@ void RView::Update()
     ptr3 = _drawable[k];
     ptr4 = _segmentationImageOutput[k]->GetPointerToVoxels();
 
+    // Drawable needs to be uploaded again
+    _drawableModified[k] = true;
+
     if (_isSourceViewer[k]) {
       std::swap(ptr1, ptr2);
       std::swap(lut1, lut2);
     }
 
-    switch (_viewMode) {
-      case View_A:
-        // Only display the target image
-        for (j = 0; j < _viewer[k]->GetHeight(); j++) {
-          for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-            *ptr3 = lut1->At(*ptr1);
-            ptr1++;
-            ptr3++;
-          }
-        }
-        break;
-      case View_B:
-        // Only display the source image
-        for (j = 0; j < _viewer[k]->GetHeight(); j++) {
-          for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-            *ptr3 = lut2->At(*ptr2);
-            ptr2++;
-            ptr3++;
-          }
-        }
-        break;
-      case View_VShutter:
-        // Display target and source images with a vertical shutter
-        for (j = 0; j < _viewer[k]->GetHeight(); j++) {
-          for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-            if (i < _viewMix * _viewer[k]->GetWidth()) {
+    if (_FloatDisplay == true) {
+      // Color map float intensities without quantization
+      this->UpdateDrawableFloat(k);
+    } else {
+      switch (_viewMode) {
+        case View_A:
+          // Only display the target image
+          for (j = 0; j < _viewer[k]->GetHeight(); j++) {
+            for (i = 0; i < _viewer[k]->GetWidth(); i++) {
               *ptr3 = lut1->At(*ptr1);
-            } else {
-              *ptr3 = lut2->At(*ptr2);
+              ptr1++;
+              ptr3++;
             }
-            ptr1++;
-            ptr2++;
-            ptr3++;
           }
-        }
-        break;
-      case View_HShutter:
-        // Display target and source images with a horizontal shutter
-        for (j = 0; j < _viewer[k]->GetHeight(); j++) {
-          if (j < _viewMix * _viewer[k]->GetHeight()) {
+          break;
+        case View_B:
+          // Only display the source image
+          for (j = 0; j < _viewer[k]->GetHeight(); j++) {
             for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-              *ptr3 = lut1->At(*ptr1);
-              ptr1++;
+              *ptr3 = lut2->At(*ptr2);
               ptr2++;
               ptr3++;
             }
-          } else {
+          }
+          break;
+        case View_VShutter:
+          // Display target and source images with a vertical shutter
+          for (j = 0; j < _viewer[k]->GetHeight(); j++) {
             for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-              *ptr3 = lut2->At(*ptr2);
+              if (i < _viewMix * _viewer[k]->GetWidth()) {
+                *ptr3 = lut1->At(*ptr1);
+              } else {
+                *ptr3 = lut2->At(*ptr2);
+              }
               ptr1++;
               ptr2++;
               ptr3++;
             }
           }
-        }
-        break;
-      case View_Subtraction:
-        // Display the subtraction of target and source
-        for (j = 0; j < _viewer[k]->GetHeight(); j++) {
-          for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-            if (*ptr1 >= 0 && *ptr2 >= 0) {
-              *ptr3 = _subtractionLookupTable->At(*ptr1 - *ptr2);
+          break;
+        case View_HShutter:
+          // Display target and source images with a horizontal shutter
+          for (j = 0; j < _viewer[k]->GetHeight(); j++) {
+            if (j < _viewMix * _viewer[k]->GetHeight()) {
+              for (i = 0; i < _viewer[k]->GetWidth(); i++) {
+                *ptr3 = lut1->At(*ptr1);
+                ptr1++;
+                ptr2++;
+                ptr3++;
+              }
             } else {
-              *ptr3 = Color();
+              for (i = 0; i < _viewer[k]->GetWidth(); i++) {
+                *ptr3 = lut2->At(*ptr2);
+                ptr1++;
+                ptr2++;
+                ptr3++;
+              }
             }
-            ptr1++;
-            ptr2++;
-            ptr3++;
           }
-        }
-        break;
-      case View_Checkerboard:
-        blendA = _viewMix;
-        blendB = 1 - blendA;
-        // Display target and source images in a checkerboard fashion
-        for (j = 0; j < _viewer[k]->GetHeight(); j++) {
-          for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-            ptr3->r = int(  blendA * lut1->At(*ptr1).r
-                          + blendB * lut2->At(*ptr2).r);
-            ptr3->g = int(  blendA * lut1->At(*ptr1).g
-                          + blendB * lut2->At(*ptr2).g);
-            ptr3->b = int(  blendA * lut1->At(*ptr1).b
-                          + blendB * lut2->At(*ptr2).b);
-            ptr1++;
-            ptr2++;
-            ptr3++;
+          break;
+        case View_Subtraction:
+          // Display the subtraction of target and source
+          for (j = 0; j < _viewer[k]->GetHeight(); j++) {
+            for (i = 0; i < _viewer[k]->GetWidth(); i++) {
+              if (*ptr1 >= 0 && *ptr2 >= 0) {
+                *ptr3 = _subtractionLookupTable->At(*ptr1 - *ptr2);
+              } else {
+                *ptr3 = Color();
+              }
+              ptr1++;
+              ptr2++;
+              ptr3++;
+            }
           }
-        }
-        break;
-      case View_AoverB:
-        // Display target and source images in a checkerboard fashion
-        for (j = 0; j < _viewer[k]->GetHeight(); j++) {
-          for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-            ptr3->r = int(     lut1->At(*ptr1).a
-                             * lut1->At(*ptr1).r +
-                          (1 - lut1->At(*ptr1).a)
-                             * lut2->At(*ptr2).r);
-            ptr3->g = int(     lut1->At(*ptr1).a
-                             * lut1->At(*ptr1).g +
-                          (1 - lut1->At(*ptr1).a)
-                             * lut2->At(*ptr2).g);
-            ptr3->b = int(     lut1->At(*ptr1).a
-                             * lut1->At(*ptr1).b +
-                          (1 - lut1->At(*ptr1).a)
-                             * lut2->At(*ptr2).b);
-            ptr1++;
-            ptr2++;
-            ptr3++;
+          break;
+        case View_Checkerboard:
+          blendA = _viewMix;
+          blendB = 1 - blendA;
+          // Display target and source images in a checkerboard fashion
+          for (j = 0; j < _viewer[k]->GetHeight(); j++) {
+            for (i = 0; i < _viewer[k]->GetWidth(); i++) {
+              ptr3->r = int(  blendA * lut1->At(*ptr1).r
+                            + blendB * lut2->At(*ptr2).r);
+              ptr3->g = int(  blendA * lut1->At(*ptr1).g
+                            + blendB * lut2->At(*ptr2).g);
+              ptr3->b = int(  blendA * lut1->At(*ptr1).b
+                            + blendB * lut2->At(*ptr2).b);
+              ptr1++;
+              ptr2++;
+              ptr3++;
+            }
           }
-        }
-        break;
-      case View_BoverA:
-        // Display target and source images in a checkerboard fashion
-        for (j = 0; j < _viewer[k]->GetHeight(); j++) {
-          for (i = 0; i < _viewer[k]->GetWidth(); i++) {
-            ptr3->r = int((1 - lut2->At(*ptr2).a)
-                          * lut1->At(*ptr1).r
-                          + lut2->At(*ptr2).a
-                          * lut2->At(*ptr2).r);
-            ptr3->g = int((1 - lut2->At(*ptr2).a)
-                          * lut1->At(*ptr1).g
-                          + lut2->At(*ptr2).a
-                          * lut2->At(*ptr2).g);
-            ptr3->b = int((1 - lut2->At(*ptr2).a)
-                          * lut1->At(*ptr1).b
-                          + lut2->At(*ptr2).a
-                          * lut2->At(*ptr2).b);
-            ptr1++;
-            ptr2++;
-            ptr3++;
+          break;
+        case View_AoverB:
+          // Display target and source images in a checkerboard fashion
+          for (j = 0; j < _viewer[k]->GetHeight(); j++) {
+            for (i = 0; i < _viewer[k]->GetWidth(); i++) {
+              ptr3->r = int(     lut1->At(*ptr1).a
+                               * lut1->At(*ptr1).r +
+                            (1 - lut1->At(*ptr1).a)
+                               * lut2->At(*ptr2).r);
+              ptr3->g = int(     lut1->At(*ptr1).a
+                               * lut1->At(*ptr1).g +
+                            (1 - lut1->At(*ptr1).a)
+                               * lut2->At(*ptr2).g);
+              ptr3->b = int(     lut1->At(*ptr1).a
+                               * lut1->At(*ptr1).b +
+                            (1 - lut1->At(*ptr1).a)
+                               * lut2->At(*ptr2).b);
+              ptr1++;
+              ptr2++;
+              ptr3++;
+            }
           }
-        }
-        break;
+          break;
+        case View_BoverA:
+          // Display target and source images in a checkerboard fashion
+          for (j = 0; j < _viewer[k]->GetHeight(); j++) {
+            for (i = 0; i < _viewer[k]->GetWidth(); i++) {
+              ptr3->r = int((1 - lut2->At(*ptr2).a)
+                            * lut1->At(*ptr1).r
+                            + lut2->At(*ptr2).a
+                            * lut2->At(*ptr2).r);
+              ptr3->g = int((1 - lut2->At(*ptr2).a)
+                            * lut1->At(*ptr1).g
+                            + lut2->At(*ptr2).a
+                            * lut2->At(*ptr2).g);
+              ptr3->b = int((1 - lut2->At(*ptr2).a)
+                            * lut1->At(*ptr1).b
+                            + lut2->At(*ptr2).a
+                            * lut2->At(*ptr2).b);
+              ptr1++;
+              ptr2++;
+              ptr3++;
+            }
+          }
+          break;
+      }
     }
 
     if (_DisplaySegmentationLabels == true) {
@@ -416,15 +924,13 @@ void RView::Update()
       for (j = 0; j < _viewer[k]->GetHeight(); j++) {
         for (i = 0; i < _viewer[k]->GetWidth(); i++) {
           if (*ptr4 >= 0) {
-            if (_segmentTable->_entry[*ptr4]._visible == true) {
-              blendA = _segmentTable->_entry[*ptr4]._trans;
-              blendB = 1 - blendA;
-              ptr3->r = int((blendB * ptr3->r) + (blendA
-                                                  * _segmentTable->_entry[*ptr4]._color.r));
-              ptr3->g = int((blendB * ptr3->g) + (blendA
-                                                  * _segmentTable->_entry[*ptr4]._color.g));
-              ptr3->b = int((blendB * ptr3->b) + (blendA
-                                                  * _segmentTable->_entry[*ptr4]._color.b));
+            // Invisible segments have zero opacity
+            display = _segmentTable->GetDisplay(*ptr4);
+            alpha = display->alpha;
+            if (alpha > 0) {
+              ptr3->r = (ptr3->r * (256 - alpha) + display->r * alpha) >> 8;
+              ptr3->g = (ptr3->g * (256 - alpha) + display->g * alpha) >> 8;
+              ptr3->b = (ptr3->b * (256 - alpha) + display->b * alpha) >> 8;
             }
           }
           ptr3++;
@@ -454,7 +960,16 @@ void RView::Update()
 
 void RView::Draw()
 {
-  int k;
+  int k, l;
+  double targetLevels[MAX_ISOLINES], sourceLevels[MAX_ISOLINES];
+
+  // Iso-levels are spaced evenly from min. towards max. display intensity
+  for (l = 0; l < _IsolineLevels; l++) {
+    targetLevels[l] = _targetLookupTable->GetMinDisplayIntensity() + l *
+      (_targetLookupTable->GetMaxDisplayIntensity() - _targetLookupTable->GetMinDisplayIntensity()) / double(_IsolineLevels);
+    sourceLevels[l] = _sourceLookupTable->GetMinDisplayIntensity() + l *
+      (_sourceLookupTable->GetMaxDisplayIntensity() - _sourceLookupTable->GetMinDisplayIntensity()) / double(_IsolineLevels);
+  }
 
   // Clear window
   glClear( GL_COLOR_BUFFER_BIT);
@@ -486,25 +1001,27 @@ void RView::Draw()
 //    display_correspondences = (display_target_landmarks && display_source_landmarks);
     display_correspondences = false;
 
-    // Draw the image
-    _viewer[k]->DrawImage(_drawable[k]);
+    // Draw the image (only changed rows are uploaded)
+    _viewer[k]->DrawImage(_drawable[k], _drawableModified[k]);
+    _drawableModified[k] = false;
 
     // Make sure to clip everything to this viewer
     _viewer[k]->Clip();
 
     // Draw iso-contours in target image if needed
     if (display_target_contour) {
-      _viewer[k]->DrawIsolines(_targetImageOutput[k],
-                               _targetLookupTable->GetMinDisplayIntensity());
+      _viewer[k]->DrawIsolines(_targetImageOutput[k], _IsolineLevels,
+                               targetLevels, _targetOutputVersion);
     }
     // Draw iso-contours in source image if needed
     if (display_source_contour) {
-      _viewer[k]->DrawIsolines(_sourceImageOutput[k],
-                               _sourceLookupTable->GetMinDisplayIntensity());
+      _viewer[k]->DrawIsolines(_sourceImageOutput[k], _IsolineLevels,
+                               sourceLevels, _sourceOutputVersion);
     }
     // Draw segmentation if needed
     if (display_segmentation_contours) {
-      _viewer[k]->DrawSegmentationContour(_segmentationImageOutput[k]);
+      _viewer[k]->DrawSegmentationContour(_segmentationImageOutput[k],
+                                          _segmentationOutputVersion);
     }
     // Draw tag grid if needed
     if (_ViewTAG) {
@@ -642,6 +1159,73 @@ void RView::ResetROI()
   _targetImage->ImageToWorld(_x2, _y2, _z2);
 }
 
+/// Compute statistics of an image in the bounding box of the ROI corners
+static void ComputeROIStatistics(ROIStatistics &statistics, mirtk::Image *image,
+                                 double x1, double y1, double z1, double x2, double y2, double z2)
+{
+  image->WorldToImage(x1, y1, z1);
+  image->WorldToImage(x2, y2, z2);
+  if (x1 > x2) std::swap(x1, x2);
+  if (y1 > y2) std::swap(y1, y2);
+  if (z1 > z2) std::swap(z1, z2);
+  statistics.Compute(round(x1), round(y1), round(z1), round(x2), round(y2), round(z2));
+}
+
+const ROIStatistics *RView::GetTargetROIStatistics()
+{
+  // Tables are built once per frame, after which any ROI is evaluated quickly
+  _targetROIStatistics.Initialize(_targetImage, _targetFrame,
+                                  _targetStatistics.GetMin(), _targetStatistics.GetMax());
+  ComputeROIStatistics(_targetROIStatistics, _targetImage, _x1, _y1, _z1, _x2, _y2, _z2);
+  return &_targetROIStatistics;
+}
+
+const ROIStatistics *RView::GetSourceROIStatistics()
+{
+  int i;
+  double x, y, z, x1, y1, z1, x2, y2, z2, i1, j1, k1, i2, j2, k2;
+
+  // Tables are built once per frame, after which any ROI is evaluated quickly
+  _sourceROIStatistics.Initialize(_sourceImage, _sourceFrame,
+                                  _sourceStatistics.GetMin(), _sourceStatistics.GetMax());
+  if ((_sourceTransformApply != true) || (_targetImage->IsEmpty() == true)) {
+    ComputeROIStatistics(_sourceROIStatistics, _sourceImage, _x1, _y1, _z1, _x2, _y2, _z2);
+    return &_sourceROIStatistics;
+  }
+
+  // Bounding box in the source of the ROI corners mapped as the source is displayed
+  x1 = _x1;
+  y1 = _y1;
+  z1 = _z1;
+  x2 = _x2;
+  y2 = _y2;
+  z2 = _z2;
+  _targetImage->WorldToImage(x1, y1, z1);
+  _targetImage->WorldToImage(x2, y2, z2);
+  i1 = j1 = k1 = DBL_MAX;
+  i2 = j2 = k2 = -DBL_MAX;
+  for (i = 0; i < 8; i++) {
+    x = (i & 1) ? x2 : x1;
+    y = (i & 2) ? y2 : y1;
+    z = (i & 4) ? z2 : z1;
+    _targetImage->ImageToWorld(x, y, z);
+    if (_sourceTransformInvert == true) {
+      this->InverseTransform(x, y, z);
+    } else {
+      this->Transform(x, y, z);
+    }
+    _sourceImage->WorldToImage(x, y, z);
+    if (x < i1) i1 = x;
+    if (y < j1) j1 = y;
+    if (z < k1) k1 = z;
+    if (x > i2) i2 = x;
+    if (y > j2) j2 = y;
+    if (z > k2) k2 = z;
+  }
+  _sourceROIStatistics.Compute(round(i1), round(j1), round(k1), round(i2), round(j2), round(k2));
+  return &_sourceROIStatistics;
+}
+
 void RView::UpdateROI1(int i, int j)
 {
   int k;
@@ -888,21 +1472,26 @@ void RView::ClearContour()
 
 void RView::FillContour(int fill, int)
 {
-  int i, j, k;
+  int i, j, k, x, y, z;
   mirtk::Point p;
+  LabelChange change;
 
   if (_segmentationImage->IsEmpty() == true) {
     // Create image
     _segmentationImage->Initialize(_targetImage->GetImageAttributes());
 
     // Fill image with zeros
-    mirtk::GreyPixel *ptr = _segmentationImage->GetPointerToVoxels();
+    int *ptr = _segmentationImage->GetPointerToVoxels();
     for (i = 0; i < _segmentationImage->GetNumberOfVoxels(); i++) {
       *ptr = 0;
       ptr++;
     }
   }
 
+  // Record changed voxels (used for incremental updates, e.g. histograms)
+  _labelChanges.clear();
+  change._new = fill;
+
   for (k = 0; k < _voxelContour._raster->GetZ(); k++) {
     for (j = 0; j < _voxelContour._raster->GetY(); j++) {
       for (i = 0; i < _voxelContour._raster->GetX(); i++) {
@@ -912,7 +1501,15 @@ void RView::FillContour(int fill, int)
           p._z = k;
           _voxelContour._raster->ImageToWorld(p);
           _segmentationImage->WorldToImage(p);
-          _segmentationImage->Put(round(p._x), round(p._y), round(p._z), fill);
+          x = round(p._x);
+          y = round(p._y);
+          z = round(p._z);
+          change._old = _segmentationImage->Get(x, y, z);
+          if (change._old != change._new) {
+            change._index = _segmentationImage->VoxelToIndex(x, y, z);
+            _labelChanges.push_back(change);
+          }
+          _segmentationImage->Put(x, y, z, fill);
         }
       }
     }
@@ -1640,27 +2237,86 @@ void RView::Write(char *name)
   to.close();
 }
 
-void RView::ReadTarget(char *name)
+/// Value range of the lookup table domain and display range for given image statistics
+static void AutoWindow(const ImageStatistics &statistics, double p1, double p2, double &min, double &max, double &displayMin, double &displayMax)
 {
-  // Read target image
-  if (_targetImage != NULL) delete _targetImage;
-  _targetImage = mirtk::Image::New(name);
-  if (!_targetImage->GetTSize()) _targetImage->PutTSize(1.0);
+  double range;
+
+  // Display range covers given percentiles, ignoring outliers
+  statistics.GetPercentileRange(p1, p2, displayMin, displayMax);
+
+  // Domain of the lookup table (mapped onto 0..10000) is chosen such that the whole intensity
+  // range fills the non-negative 16-bit reslice output, so any window within it can be displayed
+  range = statistics.GetMax() - statistics.GetMin();
+  if (range <= 0) range = 1;
+  min = statistics.GetMin();
+  max = min + range * 10000.0 / SHRT_MAX;
+}
+
+void RView::AutoWindowTarget()
+{
+  double displayMin, displayMax;
+
+  _targetMin = _targetStatistics.GetMin();
+  _targetMax = _targetStatistics.GetMax();
+  AutoWindow(_targetStatistics, _AutoWindowMin, _AutoWindowMax, _targetDomainMin, _targetDomainMax, displayMin, displayMax);
+  _targetLookupTable->Initialize(0, SHRT_MAX);
+  this->SetDisplayMinTarget(displayMin);
+  this->SetDisplayMaxTarget(displayMax);
+  _RegionGrowingThresholdMin = _targetStatistics.GetMin();
+  _RegionGrowingThresholdMax = _targetStatistics.GetMax();
+
+  // Initialize lookup table for subtraction
+  _subtractionMin = _targetMin - _sourceMax;
+  _subtractionMax = _targetMax - _sourceMin;
+  _subtractionDisplayMin = _subtractionMin;
+  _subtractionDisplayMax = _subtractionMax;
+  _subtractionLookupTable->Initialize(-SHRT_MAX, SHRT_MAX);
+}
 
-  // Find min and max values and initialize lookup table
-  _targetImage->GetMinMaxAsDouble(&_targetMin, &_targetMax);
-  _targetLookupTable->Initialize(0, 10000);
-  _targetDisplayMin = _targetMin;
-  _targetDisplayMax = _targetMax;
-  _RegionGrowingThresholdMin = _targetMin;
-  _RegionGrowingThresholdMax = _targetMax;
+void RView::AutoWindowSource()
+{
+  double displayMin, displayMax;
+
+  _sourceMin = _sourceStatistics.GetMin();
+  _sourceMax = _sourceStatistics.GetMax();
+  AutoWindow(_sourceStatistics, _AutoWindowMin, _AutoWindowMax, _sourceDomainMin, _sourceDomainMax, displayMin, displayMax);
+  _sourceLookupTable->Initialize(0, SHRT_MAX);
+  this->SetDisplayMinSource(displayMin);
+  this->SetDisplayMaxSource(displayMax);
 
   // Initialize lookup table for subtraction
   _subtractionMin = _targetMin - _sourceMax;
   _subtractionMax = _targetMax - _sourceMin;
   _subtractionDisplayMin = _subtractionMin;
   _subtractionDisplayMax = _subtractionMax;
-  _subtractionLookupTable->Initialize(-10000, 10000);
+  _subtractionLookupTable->Initialize(-SHRT_MAX, SHRT_MAX);
+}
+
+void RView::SetAutoWindowPercentiles(double p1, double p2)
+{
+  _AutoWindowMin = p1;
+  _AutoWindowMax = p2;
+
+  // Reapply to loaded images without rescanning them
+  if (_targetStatistics.IsEmpty() == false) this->AutoWindowTarget();
+  if (_sourceStatistics.IsEmpty() == false) this->AutoWindowSource();
+  this->Initialize(false);
+}
+
+void RView::ReadTarget(char *name)
+{
+  // Read target image
+  if (_targetImage != NULL) delete _targetImage;
+  _targetImage = mirtk::Image::New(name);
+  if (!_targetImage->GetTSize()) _targetImage->PutTSize(1.0);
+
+  // Compute intensity statistics and initialize lookup table
+  _targetStatistics.Compute(_targetImage);
+  _targetCoefficients.Clear();
+  _targetSinc.Clear();
+  _targetROIStatistics.Clear();
+  this->AutoWindowTarget();
 
   // Find bounding box
   _x1 = 0;
@@ -1754,20 +2410,12 @@ void RView::ReadTarget(int argc, char **argv)
   }
   delete[] nimages;
 
-  // Find min and max values and initialize lookup table
-  _targetImage->GetMinMaxAsDouble(&_targetMin, &_targetMax);
-  _targetLookupTable->Initialize(0, 10000);
-  _targetDisplayMin = _targetMin;
-  _targetDisplayMax = _targetMax;
-  _RegionGrowingThresholdMin = _targetMin;
-  _RegionGrowingThresholdMax = _targetMax;
-
-  // Initialize lookup table for subtraction
-  _subtractionMin = _targetMin - _sourceMax;
-  _subtractionMax = _targetMax - _sourceMin;
-  _subtractionDisplayMin = _subtractionMin;
-  _subtractionDisplayMax = _subtractionMax;
-  _subtractionLookupTable->Initialize(-10000, 10000);
+  // Compute intensity statistics and initialize lookup table
+  _targetStatistics.Compute(_targetImage);
+  _targetCoefficients.Clear();
+  _targetSinc.Clear();
+  _targetROIStatistics.Clear();
+  this->AutoWindowTarget();
 
   // Find bounding box
   _x1 = 0;
@@ -1794,19 +2442,12 @@ void RView::ReadSource(char *name)
   _sourceImage = mirtk::Image::New(name);
   if (!_sourceImage->GetTSize()) _sourceImage->PutTSize(1.0);
 
-  // Find min and max values and initialize lookup table
-  _sourceImage->GetMinMaxAsDouble(&_sourceMin, &_sourceMax);
-  _sourceLookupTable->Initialize(0, 10000);
-  _sourceDisplayMin = _sourceMin;
-  _sourceDisplayMax = _sourceMax;
-
-  // Initialize lookup table for subtraction
-  _subtractionMin = _targetMin - _sourceMax;
-  _subtractionMax = _targetMax - _sourceMin;
-  _subtractionLookupTable->Initialize(_subtractionMin, _subtractionMax);
-  _subtractionDisplayMin = _subtractionMin;
-  _subtractionDisplayMax = _subtractionMax;
-  _subtractionLookupTable->Initialize(-10000, 10000);
+  // Compute intensity statistics and initialize lookup table
+  _sourceStatistics.Compute(_sourceImage);
+  _sourceCoefficients.Clear();
+  _sourceSinc.Clear();
+  _sourceROIStatistics.Clear();
+  this->AutoWindowSource();
 
   // Update of source is required
   _sourceUpdate = true;
@@ -1886,19 +2527,12 @@ void RView::ReadSource(int argc, char **argv)
   }
   delete[] nimages;
 
-  // Find min and max values and initialize lookup table
-  _sourceImage->GetMinMaxAsDouble(&_sourceMin, &_sourceMax);
-  _sourceLookupTable->Initialize(0, 10000);
-  _sourceDisplayMin = _sourceMin;
-  _sourceDisplayMax = _sourceMax;
-
-  // Initialize lookup table for subtraction
-  _subtractionMin = _targetMin - _sourceMax;
-  _subtractionMax = _targetMax - _sourceMin;
-  _subtractionLookupTable->Initialize(_subtractionMin, _subtractionMax);
-  _subtractionDisplayMin = _subtractionMin;
-  _subtractionDisplayMax = _subtractionMax;
-  _subtractionLookupTable->Initialize(-10000, 10000);
+  // Compute intensity statistics and initialize lookup table
+  _sourceStatistics.Compute(_sourceImage);
+  _sourceCoefficients.Clear();
+  _sourceSinc.Clear();
+  _sourceROIStatistics.Clear();
+  this->AutoWindowSource();
 
   // Update of source is required
   _sourceUpdate = true;
@@ -1977,6 +2611,7 @@ void RView::ReadTransformation(char *name)
     _sourceTransform = tmpTransform;
   }
   _sourceUpdate = true;
+  _sourceTransformVersion++;
 
   // Set up the filters
   for (i = 0; i < _NoOfViewers; i++) {
@@ -1989,7 +2624,6 @@ void RView::ReadTransformation(char *name)
     // Set inputs and outputs for the transformation filter
     _sourceTransformFilter[i]->Input (_sourceImage);
     _sourceTransformFilter[i]->Output(_sourceImageOutput[i]);
-    _sourceTransformFilter[i]->Cache (&_sourceTransformCache);
     if (_sourceTransformApply == true) {
       _sourceTransformFilter[i]->Transformation(_sourceTransform);
     } else {
@@ -2370,107 +3004,155 @@ void RView::Resize(int w, int h)
   _selectionUpdate = true;
 
   this->Clip();
-  this->Initialize();
 
-  // Delete old drawables
-  for (i = 0; i < _NoOfViewers; i++) {
-    if (_drawable[i] != NULL)
-      delete[] _drawable[i];
-  }
+  // The displacement cache does not depend on the screen size
+  this->Initialize(false);
 
-  // Allocate new drawables
-  for (i = 0; i < _NoOfViewers; i++) {
-    int n = _targetImageOutput[i]->GetNumberOfVoxels();
-    _drawable[i] = new Color[n];
-  }
+  // Reuse drawables unless they are too small
+  this->AllocateDrawables();
 
   this->Update();
 }
 
-void RView::Configure(RViewConfig config[])
+void RView::AllocateDrawables()
 {
-  int i;
+  int i, n;
 
-  // Delete transformation filter, images and viewers
   for (i = 0; i < _NoOfViewers; i++) {
-    delete   _targetTransformFilter[i];
-    delete   _sourceTransformFilter[i];
-    delete   _segmentationTransformFilter[i];
-    delete   _selectionTransformFilter[i];
-    delete   _targetImageOutput[i];
-    delete   _sourceImageOutput[i];
-    delete   _segmentationImageOutput[i];
-    delete   _selectionImageOutput[i];
-    delete   _viewer[i];
-    delete[] _drawable[i];
-  }
-
-  // Delete array for transformation filter, images and viewers
-  if (_NoOfViewers > 0) {
-    delete[] _targetTransformFilter;
-    delete[] _sourceTransformFilter;
-    delete[] _segmentationTransformFilter;
-    delete[] _selectionTransformFilter;
-    delete[] _targetImageOutput;
-    delete[] _sourceImageOutput;
-    delete[] _segmentationImageOutput;
-    delete[] _selectionImageOutput;
-    delete[] _viewer;
-    delete[] _isSourceViewer;
-    delete[] _drawable;
+    n = _targetImageOutput[i]->GetNumberOfVoxels();
+    if (n > _drawableSize[i]) {
+      // Grow geometrically to avoid reallocation on every resize
+      if (n < 2 * _drawableSize[i]) n = 2 * _drawableSize[i];
+      delete[] _drawable[i];
+      _drawable[i] = new Color[n];
+      _drawableSize[i] = n;
+      _drawableModified[i] = true;
+    }
   }
+}
+
+void RView::Configure(RViewConfig config[])
+{
+  int i, n;
 
   // Calculate number of viewers
   for (i = 0; config[i].xmin >= 0; i++);
   _NoOfViewers = i;
 
-  // Allocate array for transformation filters
-  _targetTransformFilter = new mirtk::ImageTransformation*[_NoOfViewers];
-  _sourceTransformFilter = new mirtk::ImageTransformation*[_NoOfViewers];
-  _segmentationTransformFilter = new mirtk::ImageTransformation*[_NoOfViewers];
-  _selectionTransformFilter = new mirtk::ImageTransformation*[_NoOfViewers];
-
-  // Allocate array for images
-  _targetImageOutput = new mirtk::GreyImage*[_NoOfViewers];
-  _sourceImageOutput = new mirtk::GreyImage*[_NoOfViewers];
-  _segmentationImageOutput = new mirtk::GreyImage*[_NoOfViewers];
-  _selectionImageOutput = new mirtk::GreyImage*[_NoOfViewers];
+  // Grow arrays for transformation filters, images, viewers and drawables.
+  // Filters, images and drawables of previous configurations are kept and
+  // reused, only the viewers themselves are reconfigured.
+  if (_NoOfViewers > _NoOfViewersAllocated) {
+    n = 2 * _NoOfViewersAllocated;
+    if (n < _NoOfViewers) n = _NoOfViewers;
+
+    mirtk::ImageTransformation **targetTransformFilter       = new mirtk::ImageTransformation*[n];
+    mirtk::ImageTransformation **sourceTransformFilter       = new mirtk::ImageTransformation*[n];
+    mirtk::ImageTransformation **segmentationTransformFilter = new mirtk::ImageTransformation*[n];
+    mirtk::ImageTransformation **selectionTransformFilter    = new mirtk::ImageTransformation*[n];
+    mirtk::GreyImage **targetImageOutput       = new mirtk::GreyImage*[n];
+    mirtk::GreyImage **sourceImageOutput       = new mirtk::GreyImage*[n];
+    mirtk::GenericImage<float> **targetImageOutputFloat = new mirtk::GenericImage<float>*[n];
+    mirtk::GenericImage<float> **sourceImageOutputFloat = new mirtk::GenericImage<float>*[n];
+    mirtk::GenericImage<int> **segmentationImageOutput = new mirtk::GenericImage<int>*[n];
+    mirtk::GreyImage **selectionImageOutput    = new mirtk::GreyImage*[n];
+    Viewer **viewer       = new Viewer*[n];
+    bool  *isSourceViewer = new bool[n];
+    Color **drawable      = new Color*[n];
+    int   *drawableSize   = new int[n];
+    bool  *drawableModified = new bool[n];
+
+    for (i = 0; i < _NoOfViewersAllocated; i++) {
+      targetTransformFilter[i]       = _targetTransformFilter[i];
+      sourceTransformFilter[i]       = _sourceTransformFilter[i];
+      segmentationTransformFilter[i] = _segmentationTransformFilter[i];
+      selectionTransformFilter[i]    = _selectionTransformFilter[i];
+      targetImageOutput[i]           = _targetImageOutput[i];
+      sourceImageOutput[i]           = _sourceImageOutput[i];
+      targetImageOutputFloat[i]      = _targetImageOutputFloat[i];
+      sourceImageOutputFloat[i]      = _sourceImageOutputFloat[i];
+      segmentationImageOutput[i]     = _segmentationImageOutput[i];
+      selectionImageOutput[i]        = _selectionImageOutput[i];
+      viewer[i]                      = _viewer[i];
+      drawable[i]                    = _drawable[i];
+      drawableSize[i]                = _drawableSize[i];
+      drawableModified[i]            = _drawableModified[i];
+    }
+    for (i = _NoOfViewersAllocated; i < n; i++) {
+      targetTransformFilter[i]       = new mirtk::ImageTransformation;
+      sourceTransformFilter[i]       = new mirtk::ImageTransformation;
+      segmentationTransformFilter[i] = new mirtk::ImageTransformation;
+      selectionTransformFilter[i]    = new mirtk::ImageTransformation;
+      targetImageOutput[i]           = new mirtk::GreyImage;
+      sourceImageOutput[i]           = new mirtk::GreyImage;
+      targetImageOutputFloat[i]      = new mirtk::GenericImage<float>;
+      sourceImageOutputFloat[i]      = new mirtk::GenericImage<float>;
+      segmentationImageOutput[i]     = new mirtk::GenericImage<int>;
+      selectionImageOutput[i]        = new mirtk::GreyImage;
+      viewer[i]                      = new Viewer(this, Viewer_None);
+      drawable[i]                    = NULL;
+      drawableSize[i]                = 0;
+      drawableModified[i]            = true;
+    }
 
-  // Allocate array for viewers
-  _viewer = new Viewer*[_NoOfViewers];
-  _isSourceViewer = new bool[_NoOfViewers];
+    if (_NoOfViewersAllocated > 0) {
+      delete[] _targetTransformFilter;
+      delete[] _sourceTransformFilter;
+      delete[] _segmentationTransformFilter;
+      delete[] _selectionTransformFilter;
+      delete[] _targetImageOutput;
+      delete[] _sourceImageOutput;
+      delete[] _targetImageOutputFloat;
+      delete[] _sourceImageOutputFloat;
+      delete[] _segmentationImageOutput;
+      delete[] _selectionImageOutput;
+      delete[] _viewer;
+      delete[] _isSourceViewer;
+      delete[] _drawable;
+      delete[] _drawableSize;
+      delete[] _drawableModified;
+    }
 
-  // Allocate array for drawables
-  _drawable = new Color*[_NoOfViewers];
+    _targetTransformFilter       = targetTransformFilter;
+    _sourceTransformFilter       = sourceTransformFilter;
+    _segmentationTransformFilter = segmentationTransformFilter;
+    _selectionTransformFilter    = selectionTransformFilter;
+    _targetImageOutput           = targetImageOutput;
+    _sourceImageOutput           = sourceImageOutput;
+    _targetImageOutputFloat      = targetImageOutputFloat;
+    _sourceImageOutputFloat      = sourceImageOutputFloat;
+    _segmentationImageOutput     = segmentationImageOutput;
+    _selectionImageOutput        = selectionImageOutput;
+    _viewer                      = viewer;
+    _isSourceViewer              = isSourceViewer;
+    _drawable                    = drawable;
+    _drawableSize                = drawableSize;
+    _drawableModified            = drawableModified;
+    _NoOfViewersAllocated        = n;
+  }
 
   // Configure each viewer
   bool source_viewer[4] = {false, false, false, false};
   for (i = 0; i < _NoOfViewers; i++) {
 
-    // Allocate _target viewer
-    _viewer[i] = new Viewer(this, config[i].mode);
+    // Configure _target viewer
+    _viewer[i]->SetViewerMode(config[i].mode);
     _isSourceViewer[i] = source_viewer[config[i].mode];
     source_viewer[config[i].mode] = !source_viewer[config[i].mode];
 
-    // Configure _target viewer
     _viewer[i]->SetViewport(config[i].xmin, config[i].ymin, config[i].xmax,
                             config[i].ymax);
 
     _viewer[i]->SetScreen(_screenX, _screenY);
 
-    _targetImageOutput[i] = new mirtk::GreyImage;
-    _targetTransformFilter[i] = new mirtk::ImageTransformation;
     _targetTransformFilter[i]->Input(_targetImage);
     _targetTransformFilter[i]->Output(_targetImageOutput[i]);
     _targetTransformFilter[i]->Transformation(_targetTransform);
     _targetTransformFilter[i]->Interpolator(_targetInterpolator);
     _targetTransformFilter[i]->SourcePaddingValue(0);
 
-    _sourceImageOutput[i] = new mirtk::GreyImage;
-    _sourceTransformFilter[i] = new mirtk::ImageTransformation;
     _sourceTransformFilter[i]->Input(_sourceImage);
     _sourceTransformFilter[i]->Output(_sourceImageOutput[i]);
-    _sourceTransformFilter[i]->Cache(&_sourceTransformCache);
     if (_sourceTransformApply == true) {
       _sourceTransformFilter[i]->Transformation(_sourceTransform);
     } else {
@@ -2480,21 +3162,19 @@ void RView::Configure(RViewConfig config[])
     _sourceTransformFilter[i]->SourcePaddingValue(_sourceMin - 1);
     _sourceTransformFilter[i]->Invert(_sourceTransformInvert);
 
-    _segmentationImageOutput[i] = new mirtk::GreyImage;
-    _segmentationTransformFilter[i] = new mirtk::ImageTransformation;
     _segmentationTransformFilter[i]->Input(_segmentationImage);
     _segmentationTransformFilter[i]->Output(_segmentationImageOutput[i]);
     _segmentationTransformFilter[i]->Transformation(_segmentationTransform);
     _segmentationTransformFilter[i]->Interpolator(_segmentationInterpolator);
 
-    _selectionImageOutput[i] = new mirtk::GreyImage;
-    _selectionTransformFilter[i] = new mirtk::ImageTransformation;
     _selectionTransformFilter[i]->Input(_voxelContour._raster);
     _selectionTransformFilter[i]->Output(_selectionImageOutput[i]);
     _selectionTransformFilter[i]->Transformation(_selectionTransform);
     _selectionTransformFilter[i]->Interpolator(_selectionInterpolator);
   }
-  this->Initialize();
+
+  // The displacement cache does not depend on the viewer layout
+  this->Initialize(false);
 
   if (_contourViewer != -1) {
     // Delete contour
@@ -2505,10 +3185,8 @@ void RView::Configure(RViewConfig config[])
     }
   }
 
-  for (i = 0; i < _NoOfViewers; i++) {
-    // Configure OpenGL
-    _drawable[i] = new Color[_targetImageOutput[i]->GetNumberOfVoxels()];
-  }
+  // Reuse drawables unless they are too small
+  this->AllocateDrawables();
 
   // Update of target and source is required
   _targetUpdate = true;
@@ -2548,6 +3226,19 @@ void RView::GetInfoText(char *buffer1, char *buffer2, char *buffer3,
   }
   // END of added code -as12312
 
+  // Cached transformations are only valid for the same cursor and time
+  if ((_infoX != _origin_x) || (_infoY != _origin_y) || (_infoZ != _origin_z) ||
+      (_infoTS != ts) || (_infoTT != tt)) {
+    _infoX  = _origin_x;
+    _infoY  = _origin_y;
+    _infoZ  = _origin_z;
+    _infoTS = ts;
+    _infoTT = tt;
+    _infoSourceValid = false;
+    _infoSegmentationValid = false;
+  }
+  if (_sourceUpdate == true) _infoSourceValid = false;
+  if (_segmentationUpdate == true) _infoSegmentationValid = false;
 
   u = _origin_x;
   v = _origin_y;
@@ -2568,11 +3259,22 @@ void RView::GetInfoText(char *buffer1, char *buffer2, char *buffer3,
     sprintf(buffer2, " ");
     sprintf(buffer3, " ");
   }
-  u = _origin_x;
-  v = _origin_y;
-  w = _origin_z;
-  _sourceTransform->Transform(u, v, w, ts, tt);
-  point = mirtk::Point(u, v, w);
+  if (_infoSourceValid == false) {
+    u = _origin_x;
+    v = _origin_y;
+    w = _origin_z;
+    if (_sourceTransformInvert == true) {
+      this->InverseTransform(u, v, w);
+    } else {
+      this->Transform(u, v, w);
+    }
+    _infoSourcePoint = mirtk::Point(u, v, w);
+    _infoSourceValid = true;
+  }
+  point = _infoSourcePoint;
+  u = point._x;
+  v = point._y;
+  w = point._z;
   _sourceImage->WorldToImage(u, v, w);
   i = round(u);
   j = round(v);
@@ -2584,11 +3286,18 @@ void RView::GetInfoText(char *buffer1, char *buffer2, char *buffer3,
   } else {
     sprintf(buffer4, " ");
   }
-  u = _origin_x;
-  v = _origin_y;
-  w = _origin_z;
-  _segmentationTransform->Transform(u, v, w, ts, tt);
-  point = mirtk::Point(u, v, w);
+  if (_infoSegmentationValid == false) {
+    u = _origin_x;
+    v = _origin_y;
+    w = _origin_z;
+    _segmentationTransform->Transform(u, v, w, ts, tt);
+    _infoSegmentationPoint = mirtk::Point(u, v, w);
+    _infoSegmentationValid = true;
+  }
+  point = _infoSegmentationPoint;
+  u = point._x;
+  v = point._y;
+  w = point._z;
   _segmentationImage->WorldToImage(u, v, w);
   i = round(u);
   j = round(v);
@@ -2811,6 +3520,13 @@ void RView::GetTransformationText(std::list<char *> &text)
       text.push_back(ptr);
     }
   }
+
+  // Accuracy of the inverse interpolated from the dense inverse field
+  if (this->GetInverseError(dx, dy) == true) {
+    sprintf(buffer, "Inverse error: mean %.3f mm, max %.3f mm", dx, dy);
+    ptr = strdup(buffer);
+    text.push_back(ptr);
+  }
 }
 
 void RView::Initialize(bool initialize_cache)
@@ -2874,18 +3590,22 @@ void RView::Initialize(bool initialize_cache)
         break;
     }
     _targetTransformFilter[i]->Input(_targetImage);
-    _targetTransformFilter[i]->Output(_targetImageOutput[i]);
-    _targetTransformFilter[i]->ScaleFactor(10000.0 / (_targetMax - _targetMin));
-    _targetTransformFilter[i]->Offset(-_targetMin * 10000.0 / (_targetMax - _targetMin));
     _sourceTransformFilter[i]->Input(_sourceImage);
-    _sourceTransformFilter[i]->Output(_sourceImageOutput[i]);
-    _sourceTransformFilter[i]->ScaleFactor(10000.0 / (_sourceMax - _sourceMin));
-    _sourceTransformFilter[i]->Offset(-_sourceMin * 10000.0 / (_sourceMax - _sourceMin));
+
+    // Reslice original intensities, these are mapped onto 0..10000 in Update
+    _targetTransformFilter[i]->Output(_targetImageOutputFloat[i]);
+    _targetTransformFilter[i]->ScaleFactor(1);
+    _targetTransformFilter[i]->Offset(0);
+    _sourceTransformFilter[i]->Output(_sourceImageOutputFloat[i]);
+    _sourceTransformFilter[i]->ScaleFactor(1);
+    _sourceTransformFilter[i]->Offset(0);
     _sourceTransformFilter[i]->OutputTimeOffset(_targetImage->ImageToTime(_targetFrame) - _sourceImage->ImageToTime(_sourceFrame));
     attr._torigin = _targetImage->ImageToTime(_targetFrame);
     _targetImageOutput[i]->Initialize(attr);
+    _targetImageOutputFloat[i]->Initialize(attr);
     attr._torigin = _sourceImage->ImageToTime(_sourceFrame);
     _sourceImageOutput[i]->Initialize(attr);
+    _sourceImageOutputFloat[i]->Initialize(attr);
     attr._torigin = 0; // TODO
     _segmentationImageOutput[i]->Initialize(attr);
     _selectionImageOutput[i]->Initialize(attr);
@@ -2897,41 +3617,9 @@ void RView::Initialize(bool initialize_cache)
   _segmentationUpdate = true;
   _selectionUpdate = true;
 
-  // Use source transformation cache if required and enabled
-  if (initialize_cache) {
-    if (_sourceImage && _sourceTransform && _sourceTransform->RequiresCachingOfDisplacements() && _CacheDisplacements) {
-//      mirtk::MultiLevelTransformation *mffd = dynamic_cast<mirtk::MultiLevelTransformation *>(_sourceTransform);
-//      mirtk::FreeFormTransformation   *ffd  = dynamic_cast<mirtk::FreeFormTransformation   *>(_sourceTransform);
-//      if (mffd && mffd->NumberOfLevels() > 0) ffd = mffd->GetLocalTransformation(mffd->NumberOfLevels()-1);
-//      mirtk::ImageAttributes attr;
-//      if (ffd) {
-//        attr = ffd->Attributes();
-//        if (_targetImage) {
-//          attr._x  = attr._x * attr._dx / _targetImage->GetXSize();
-//          attr._y  = attr._y * attr._dy / _targetImage->GetYSize();
-//          attr._z  = attr._z * attr._dz / _targetImage->GetZSize();
-//          attr._dx = _targetImage->GetXSize();
-//          attr._dy = _targetImage->GetYSize();
-//          attr._dz = _targetImage->GetZSize();
-//        } else {
-//          attr._x  = attr._x * attr._dx / _sourceImage->GetXSize();
-//          attr._y  = attr._y * attr._dy / _sourceImage->GetYSize();
-//          attr._z  = attr._z * attr._dz / _sourceImage->GetZSize();
-//          attr._dx = _sourceImage->GetXSize();
-//          attr._dy = _sourceImage->GetYSize();
-//          attr._dz = _sourceImage->GetZSize();
-//        }
-//      } else
-      if (_targetImage) {
-        attr = _targetImage->GetImageAttributes();
-      } else {
-        attr = _sourceImage->GetImageAttributes();
-      }
-      _sourceTransformCache.Initialize(attr, 3);
-      _sourceTransformCache.Modified(true);
-    } else {
-      _sourceTransformCache.Clear();
-    }
+  // Displacements are cached in tiles as the source is resliced, release them if caching is disabled
+  if ((initialize_cache == true) && (_CacheDisplacements != true)) {
+    _sourceDisplacementCache.Clear();
   }
 }
 
@@ -3086,9 +3774,7 @@ void RView::SetSourceTransformApply(bool value)
   for (i = 0; i < _NoOfViewers; i++) {
     if (_sourceTransformApply == true) {
       _sourceTransformFilter[i]->Transformation(_sourceTransform);
-      _sourceTransformFilter[i]->Cache(&_sourceTransformCache);
     } else {
-      _sourceTransformFilter[i]->Cache(NULL);
       _sourceTransformFilter[i]->Transformation(_targetTransform);
     }
   }
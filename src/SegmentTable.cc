@@ -12,70 +12,177 @@
 
 #include <SegmentTable.h>
 
+#include <algorithm>
+
 SegmentTable::SegmentTable()
 {
+  int i;
+
+  _version = 0;
+  for (i = 0; i <= SHRT_MAX; i++) {
+    this->UpdateDisplay(i);
+  }
+
+  // The table is empty, so all labels are displayed like the default segment
+  _displayDefault = _display[0];
 }
 
 SegmentTable::~SegmentTable()
 {
+  int i;
+
+  for (i = 0; i < int(_segment.size()); i++) {
+    delete _segment[i];
+  }
+}
+
+int SegmentTable::Find(int id) const
+{
+  std::vector<int>::const_iterator it;
+
+  it = std::lower_bound(_id.begin(), _id.end(), id);
+  if ((it == _id.end()) || (*it != id)) return -1;
+  return it - _id.begin();
+}
+
+Segment *SegmentTable::Insert(int id)
+{
+  int i;
+  std::vector<int>::iterator it;
+
+  i = this->Find(id);
+  if (i >= 0) return _segment[i];
+
+  // Keep label IDs sorted
+  it = std::lower_bound(_id.begin(), _id.end(), id);
+  i  = it - _id.begin();
+  _id.insert(it, id);
+  _segment.insert(_segment.begin() + i, new Segment);
+  return _segment[i];
+}
+
+void SegmentTable::UpdateDisplay(int id)
+{
+  double alpha;
+  const Segment *segment;
+  SegmentDisplay display;
+
+  segment = this->Lookup(id);
+  segment->getColor(&display.r, &display.g, &display.b);
+  if (segment->getVisibility() == true) {
+    alpha = segment->getTrans();
+    if (alpha < 0) alpha = 0;
+    if (alpha > 1) alpha = 1;
+    display.a     = round(alpha * 255);
+    display.alpha = round(alpha * 256);
+  } else {
+    display.a     = 0;
+    display.alpha = 0;
+  }
+
+  // Labels outside the direct lookup range are only kept while they are in the table
+  if ((id >= 0) && (id <= SHRT_MAX)) {
+    _display[id] = display;
+  } else if (this->Find(id) >= 0) {
+    _displayLarge[id] = display;
+  } else {
+    _displayLarge.erase(id);
+  }
 }
 
 void SegmentTable::Set(int id, char* label, unsigned char r, unsigned char g, unsigned char b, double trans, int vis)
 {
-  _entry[id].setLabel(label);
-  _entry[id].setColor(r, g, b);
-  _entry[id].setTrans(trans);
-  _entry[id].setVisibility(vis);
+  Segment *segment = this->Insert(id);
+
+  segment->setLabel(label);
+  segment->setColor(r, g, b);
+  segment->setTrans(trans);
+  segment->setVisibility(vis);
+  this->UpdateDisplay(id);
+  _version++;
 }
 
 void SegmentTable::SetLabel(int id, char* label)
 {
-  _entry[id].setLabel(label);
+  this->Insert(id)->setLabel(label);
+  this->UpdateDisplay(id);
+  _version++;
 }
 
 void SegmentTable::SetColor(int id, unsigned char red, unsigned char green, unsigned char blue)
 {
-  _entry[id].setColor(red, green, blue);
+  int i = this->Find(id);
+
+  if (i < 0) return;
+  _segment[i]->setColor(red, green, blue);
+  this->UpdateDisplay(id);
+  _version++;
 }
 
 void SegmentTable::SetTrans(int id, double t)
 {
-  _entry[id].setTrans(t);
+  int i = this->Find(id);
+
+  if (i < 0) return;
+  _segment[i]->setTrans(t);
+  this->UpdateDisplay(id);
+  _version++;
 }
 
 void SegmentTable::SetVisibility(int id, int vis)
 {
-  _entry[id].setVisibility(vis);
+  int i = this->Find(id);
+
+  if (i < 0) return;
+  _segment[i]->setVisibility(vis);
+  this->UpdateDisplay(id);
+  _version++;
 }
 
 char *SegmentTable::Get(int id, unsigned char* r, unsigned char* g, unsigned char* b, double* trans, int* v) const
 {
+  const Segment *segment = this->Lookup(id);
+
   // Get r,g,b
-  _entry[id].getColor(r, g, b);
+  segment->getColor(r, g, b);
 
   // Get transparency
-  *trans = _entry[id].getTrans();
+  *trans = segment->getTrans();
 
   // Get visibility
-  *v = _entry[id].getVisibility();
+  *v = segment->getVisibility();
 
-  return _entry[id].getLabel();
+  return segment->getLabel();
 }
 
 void SegmentTable::Clear()
 {
   int i;
+  std::vector<int> id;
+
+  for (i = 0; i < int(_segment.size()); i++) {
+    delete _segment[i];
+  }
+  _segment.clear();
+  id.swap(_id);
 
-  for (i = 0; i < this->Size(); i++) {
-    if (IsValid(i) == true) Clear(i);
+  // Reset display properties of removed segments
+  for (i = 0; i < int(id.size()); i++) {
+    this->UpdateDisplay(id[i]);
   }
+  _version++;
 }
 
 void SegmentTable::Clear(int id)
 {
-  _entry[id].setLabel(NULL);
-  _entry[id].setColor(0, 0, 0);
-  _entry[id].setTrans(0);
+  int i = this->Find(id);
+
+  if (i < 0) return;
+  delete _segment[i];
+  _segment.erase(_segment.begin() + i);
+  _id.erase(_id.begin() + i);
+  this->UpdateDisplay(id);
+  _version++;
 }
 
 void SegmentTable::Read(char *name)
@@ -83,6 +190,7 @@ void SegmentTable::Read(char *name)
   double trans;
   char c, buffer[256];
   int i, n, r, g, b, id, vis;
+  Segment *segment;
 
   // Clear entries
   Clear();
@@ -115,16 +223,19 @@ void SegmentTable::Read(char *name)
       }
     }
     from.getline(buffer, 255);
-    _entry[id].setLabel(buffer);
-    _entry[id].setColor(r, g, b);
-    _entry[id].setTrans(trans);
-    _entry[id].setVisibility(vis);
+    segment = this->Insert(id);
+    segment->setLabel(buffer);
+    segment->setColor(r, g, b);
+    segment->setTrans(trans);
+    segment->setVisibility(vis);
+    this->UpdateDisplay(id);
   }
+  _version++;
 }
 
 void SegmentTable::Write(char *name)
 {
-  int id, n;
+  int i, n;
   unsigned char r, g, b;
 
   // Open file
@@ -135,21 +246,16 @@ void SegmentTable::Write(char *name)
     exit(1);
   }
 
-  // Count number of valid entries
-  n = 0;
-  for (id = 0; id < this->Size(); id++) {
-    if (IsValid(id) == true) n++;
-  }
+  // Number of valid entries
+  n = this->NumberOfSegments();
 
   // Write header
   to << "SegmentTable: " << n << std::endl;
 
   // Write entries
-  for (id = 0; id < this->Size(); id++) {
-    if (IsValid(id) == true) {
-      _entry[id].getColor(&r, &g, &b);
-      to << id << "\t" << int(r) << "\t" << int(g) << "\t" << int(b) << "\t" << _entry[id].getTrans()<< "\t" << _entry[id].getVisibility() << "\t" << _entry[id].getLabel() << std::endl;
-    }
+  for (i = 0; i < n; i++) {
+    _segment[i]->getColor(&r, &g, &b);
+    to << _id[i] << "\t" << int(r) << "\t" << int(g) << "\t" << int(b) << "\t" << _segment[i]->getTrans()<< "\t" << _segment[i]->getVisibility() << "\t" << _segment[i]->getLabel() << std::endl;
   }
 }
 
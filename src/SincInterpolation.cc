@@ -0,0 +1,374 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#include <mirtk/Image.h>
+#include <mirtk/Parallel.h>
+
+#include <SincInterpolation.h>
+
+#include <cmath>
+#include <vector>
+
+/// Number of samples weighted around a point
+#define SINC_INTERPOLATION_TAPS (2 * SINC_INTERPOLATION_RADIUS)
+
+/// Index of a sample mirrored at the boundaries of a line of n samples
+static inline int MirrorIndex(int i, int n)
+{
+  if (n == 1) return 0;
+  while ((i < 0) || (i >= n)) {
+    if (i < 0) i = -i;
+    if (i >= n) i = 2 * n - 2 - i;
+  }
+  return i;
+}
+
+/// Lanczos window of the sinc at a distance from the interpolated point
+static double Lanczos(double d)
+{
+  double a;
+
+  if (fabs(d) < 1e-9) return 1;
+  if (fabs(d) >= SINC_INTERPOLATION_RADIUS) return 0;
+  a = M_PI * d;
+  return SINC_INTERPOLATION_RADIUS * sin(a) * sin(a / SINC_INTERPOLATION_RADIUS) / (a * a);
+}
+
+/// Image axis along which a step in the plane moves (-1 if it is oblique)
+static int PlaneAxis(const double *d)
+{
+  int i, axis;
+
+  axis = -1;
+  for (i = 0; i < 3; i++) {
+    if (fabs(d[i]) < 1e-6) continue;
+    if (axis >= 0) return -1;
+    axis = i;
+  }
+  return axis;
+}
+
+/// Copy of the voxels of a frame
+class SincFrameCopy
+{
+public:
+
+  /// Image and frame
+  mirtk::Image *_image;
+  int _frame;
+
+  /// Voxels of the frame (output)
+  float *_voxels;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, k;
+    float *ptr;
+
+    for (k = re.begin(); k != re.end(); k++) {
+      ptr = _voxels + k * _image->GetX() * _image->GetY();
+      for (j = 0; j < _image->GetY(); j++) {
+        for (i = 0; i < _image->GetX(); i++, ptr++) {
+          *ptr = _image->GetAsDouble(i, j, k, _frame);
+        }
+      }
+    }
+  }
+};
+
+/// Passes of the separable reslicing of a plane aligned with the image axes
+class SincPlanePass
+{
+public:
+
+  /// Pass: 0 interpolates across the plane, 1 along its rows, 2 along its columns
+  int _pass;
+
+  /// Voxels of the frame, size and stride of each image axis
+  const float *_voxels;
+  int _size[3], _stride[3];
+
+  /// Image axes of the rows, columns and normal of the plane
+  int _ai, _aj, _ac;
+
+  /// First sample and weights across the plane
+  int _c0;
+  const float *_wc;
+
+  /// Range of samples along the rows and columns which are needed
+  int _amin, _na, _bmin;
+
+  /// Number of pixels of the plane
+  int _x, _y;
+
+  /// First sample, weights and inside flag of each pixel column and row
+  const int *_i0, *_j0;
+  const float *const *_wi, *const *_wj;
+  const char *_insideI, *_insideJ;
+
+  /// Slice interpolated across the plane and after interpolation along the rows
+  float *_slice, *_rows;
+
+  /// Output values
+  double *_values;
+
+  /// Padding value
+  double _padding;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int a, b, c, i, j, t, m;
+    const float *ptr, *w;
+    float *out;
+    double sum;
+
+    for (b = re.begin(); b != re.end(); b++) {
+      if (_pass == 0) {
+        // Slice of needed samples interpolated across the plane
+        out = _slice + b * _na;
+        for (a = 0; a < _na; a++) out[a] = 0;
+        for (c = 0; c < SINC_INTERPOLATION_TAPS; c++) {
+          if (_wc[c] == 0) continue;
+          ptr = _voxels + (_bmin + b) * _stride[_aj] + MirrorIndex(_c0 + c, _size[_ac]) * _stride[_ac] + _amin * _stride[_ai];
+          for (a = 0; a < _na; a++) out[a] += _wc[c] * ptr[a * _stride[_ai]];
+        }
+      } else if (_pass == 1) {
+        // Interpolation along the rows of the plane
+        out = _rows + b * _x;
+        ptr = _slice + b * _na - _amin;
+        for (i = 0; i < _x; i++) {
+          if (_insideI[i] == false) continue;
+          w   = _wi[i];
+          sum = 0;
+          for (t = 0; t < SINC_INTERPOLATION_TAPS; t++) {
+            sum += w[t] * ptr[MirrorIndex(_i0[i] + t, _size[_ai])];
+          }
+          out[i] = sum;
+        }
+      } else {
+        // Interpolation along the columns of the plane, b is the output row
+        j = b;
+        for (i = 0; i < _x; i++) _values[j * _x + i] = 0;
+        if (_insideJ[j] == false) {
+          for (i = 0; i < _x; i++) _values[j * _x + i] = _padding;
+          continue;
+        }
+        w = _wj[j];
+        for (t = 0; t < SINC_INTERPOLATION_TAPS; t++) {
+          if (w[t] == 0) continue;
+          m   = MirrorIndex(_j0[j] + t, _size[_aj]) - _bmin;
+          ptr = _rows + m * _x;
+          for (i = 0; i < _x; i++) _values[j * _x + i] += w[t] * ptr[i];
+        }
+        for (i = 0; i < _x; i++) {
+          if (_insideI[i] == false) _values[j * _x + i] = _padding;
+        }
+      }
+    }
+  }
+};
+
+SincInterpolation::SincInterpolation()
+{
+  int p, t;
+  double f, sum;
+
+  // Weights of each phase are normalized so that constant images are reproduced exactly
+  _table.resize((SINC_INTERPOLATION_PHASES + 1) * SINC_INTERPOLATION_TAPS);
+  for (p = 0; p <= SINC_INTERPOLATION_PHASES; p++) {
+    f   = double(p) / SINC_INTERPOLATION_PHASES;
+    sum = 0;
+    for (t = 0; t < SINC_INTERPOLATION_TAPS; t++) {
+      _table[p * SINC_INTERPOLATION_TAPS + t] = Lanczos(f + SINC_INTERPOLATION_RADIUS - 1 - t);
+      sum += _table[p * SINC_INTERPOLATION_TAPS + t];
+    }
+    for (t = 0; t < SINC_INTERPOLATION_TAPS; t++) _table[p * SINC_INTERPOLATION_TAPS + t] /= sum;
+  }
+  this->Clear();
+}
+
+void SincInterpolation::Clear()
+{
+  _image = NULL;
+  _frame = -1;
+  _x = 0;
+  _y = 0;
+  _z = 0;
+  std::vector<float>().swap(_voxels);
+}
+
+void SincInterpolation::Initialize(mirtk::Image *image, int frame)
+{
+  SincFrameCopy body;
+
+  if ((image == _image) && (frame == _frame) &&
+      (image->GetX() == _x) && (image->GetY() == _y) && (image->GetZ() == _z)) return;
+  _image = image;
+  _frame = frame;
+  _x = image->GetX();
+  _y = image->GetY();
+  _z = image->GetZ();
+  _voxels.resize(_x * _y * _z);
+  body._image  = image;
+  body._frame  = frame;
+  body._voxels = &_voxels[0];
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, _z), body);
+}
+
+const float *SincInterpolation::Weights(double x, int &i0) const
+{
+  int i, p;
+
+  i  = int(floor(x));
+  p  = int((x - i) * SINC_INTERPOLATION_PHASES + 0.5);
+  i0 = i - SINC_INTERPOLATION_RADIUS + 1;
+  return &_table[p * SINC_INTERPOLATION_TAPS];
+}
+
+double SincInterpolation::Evaluate(double x, double y, double z) const
+{
+  int a, b, c, i0, j0, k0, u[SINC_INTERPOLATION_TAPS], v[SINC_INTERPOLATION_TAPS];
+  const float *wx, *wy, *wz, *ptr;
+  double value, plane, row;
+
+  wx = this->Weights(x, i0);
+  wy = this->Weights(y, j0);
+  wz = this->Weights(z, k0);
+  for (a = 0; a < SINC_INTERPOLATION_TAPS; a++) {
+    u[a] = MirrorIndex(i0 + a, _x);
+    v[a] = MirrorIndex(j0 + a, _y) * _x;
+  }
+
+  value = 0;
+  for (c = 0; c < SINC_INTERPOLATION_TAPS; c++) {
+    if (wz[c] == 0) continue;
+    plane = 0;
+    for (b = 0; b < SINC_INTERPOLATION_TAPS; b++) {
+      if (wy[b] == 0) continue;
+      ptr = &_voxels[MirrorIndex(k0 + c, _z) * _x * _y + v[b]];
+      row = 0;
+      for (a = 0; a < SINC_INTERPOLATION_TAPS; a++) row += wx[a] * ptr[u[a]];
+      plane += wy[b] * row;
+    }
+    value += wz[c] * plane;
+  }
+  return value;
+}
+
+bool SincInterpolation::ReslicePlane(mirtk::Image *output, std::vector<double> &values, double padding) const
+{
+  int i, j, amax, bmax, lo, hi;
+  double p0[3], p1[3], p2[3], di[3], dj[3], x, xmin, xmax;
+  std::vector<int> i0, j0;
+  std::vector<const float *> wi, wj;
+  std::vector<char> insideI, insideJ;
+  std::vector<float> slice, rows;
+  SincPlanePass body;
+
+  // Voxel coordinates of the first pixel and of steps along the rows and columns
+  p0[0] = 0;
+  p0[1] = 0;
+  p0[2] = 0;
+  output->ImageToWorld(p0[0], p0[1], p0[2]);
+  _image->WorldToImage(p0[0], p0[1], p0[2]);
+  p1[0] = 1;
+  p1[1] = 0;
+  p1[2] = 0;
+  output->ImageToWorld(p1[0], p1[1], p1[2]);
+  _image->WorldToImage(p1[0], p1[1], p1[2]);
+  p2[0] = 0;
+  p2[1] = 1;
+  p2[2] = 0;
+  output->ImageToWorld(p2[0], p2[1], p2[2]);
+  _image->WorldToImage(p2[0], p2[1], p2[2]);
+  for (i = 0; i < 3; i++) {
+    di[i] = p1[i] - p0[i];
+    dj[i] = p2[i] - p0[i];
+  }
+  body._ai = PlaneAxis(di);
+  body._aj = PlaneAxis(dj);
+  if ((body._ai < 0) || (body._aj < 0) || (body._ai == body._aj)) return false;
+  body._ac = 3 - body._ai - body._aj;
+  body._size[0]   = _x;
+  body._size[1]   = _y;
+  body._size[2]   = _z;
+  body._stride[0] = 1;
+  body._stride[1] = _x;
+  body._stride[2] = _x * _y;
+  body._x = output->GetX();
+  body._y = output->GetY();
+  values.assign(body._x * body._y, padding);
+
+  // Planes outside the image are empty
+  if ((p0[body._ac] <= -0.5) || (p0[body._ac] >= body._size[body._ac] - 0.5)) return true;
+  body._wc = this->Weights(p0[body._ac], body._c0);
+
+  // Weights of the pixel columns and the samples which they need
+  i0.resize(body._x);
+  wi.resize(body._x);
+  insideI.resize(body._x);
+  xmin = xmax = p0[body._ai];
+  for (i = 0; i < body._x; i++) {
+    x = p0[body._ai] + i * di[body._ai];
+    insideI[i] = ((x > -0.5) && (x < body._size[body._ai] - 0.5));
+    wi[i] = this->Weights(x, i0[i]);
+    if (x < xmin) xmin = x;
+    if (x > xmax) xmax = x;
+  }
+  lo = int(floor(xmin)) - 2 * SINC_INTERPOLATION_RADIUS;
+  hi = int(ceil(xmax)) + 2 * SINC_INTERPOLATION_RADIUS;
+  body._amin = (lo > 0) ? lo : 0;
+  amax = (hi < body._size[body._ai] - 1) ? hi : body._size[body._ai] - 1;
+  if (body._amin > amax) return true;
+  body._na = amax - body._amin + 1;
+
+  // Weights of the pixel rows and the samples which they need
+  j0.resize(body._y);
+  wj.resize(body._y);
+  insideJ.resize(body._y);
+  xmin = xmax = p0[body._aj];
+  for (j = 0; j < body._y; j++) {
+    x = p0[body._aj] + j * dj[body._aj];
+    insideJ[j] = ((x > -0.5) && (x < body._size[body._aj] - 0.5));
+    wj[j] = this->Weights(x, j0[j]);
+    if (x < xmin) xmin = x;
+    if (x > xmax) xmax = x;
+  }
+  lo = int(floor(xmin)) - 2 * SINC_INTERPOLATION_RADIUS;
+  hi = int(ceil(xmax)) + 2 * SINC_INTERPOLATION_RADIUS;
+  body._bmin = (lo > 0) ? lo : 0;
+  bmax = (hi < body._size[body._aj] - 1) ? hi : body._size[body._aj] - 1;
+  if (body._bmin > bmax) return true;
+
+  slice.resize(body._na * (bmax - body._bmin + 1));
+  rows.assign(body._x * (bmax - body._bmin + 1), 0);
+  body._voxels  = &_voxels[0];
+  body._i0      = &i0[0];
+  body._j0      = &j0[0];
+  body._wi      = &wi[0];
+  body._wj      = &wj[0];
+  body._insideI = &insideI[0];
+  body._insideJ = &insideJ[0];
+  body._slice   = &slice[0];
+  body._rows    = &rows[0];
+  body._values  = &values[0];
+  body._padding = padding;
+
+  // Each pass needs all samples of the previous one
+  body._pass = 0;
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, bmax - body._bmin + 1), body);
+  body._pass = 1;
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, bmax - body._bmin + 1), body);
+  body._pass = 2;
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, body._y), body);
+  return true;
+}
@@ -0,0 +1,277 @@
+/*=========================================================================
+
+  Library   : Image Registration Toolkit (IRTK)
+  Module    : $Id$
+  Copyright : Imperial College, Department of Computing
+              Visual Information Processing (VIP), 2008 onwards
+  Date      : $Date$
+  Version   : $Revision$
+  Changes   : $Author$
+
+=========================================================================*/
+
+#include <mirtk/Image.h>
+#include <mirtk/Parallel.h>
+
+#include <SplineCoefficientCache.h>
+
+#include <cmath>
+#include <vector>
+
+/// Pole of the cubic B-spline prefilter
+#define SPLINE_COEFFICIENT_POLE (sqrt(3.0) - 2.0)
+
+/// Relative accuracy of the initial causal coefficient
+#define SPLINE_COEFFICIENT_TOLERANCE 1e-6
+
+/// Index of a sample mirrored at the boundaries of a line of n samples
+static inline int MirrorIndex(int i, int n)
+{
+  if (n == 1) return 0;
+  while ((i < 0) || (i >= n)) {
+    if (i < 0) i = -i;
+    if (i >= n) i = 2 * n - 2 - i;
+  }
+  return i;
+}
+
+/// Convert a line of samples into cubic B-spline coefficients with mirror boundary conditions
+static void PrefilterLine(double *c, int n)
+{
+  int k, horizon;
+  double z, zn, z2n, iz, sum;
+
+  if (n == 1) return;
+  z = SPLINE_COEFFICIENT_POLE;
+  for (k = 0; k < n; k++) c[k] *= (1 - z) * (1 - 1 / z);
+
+  // Initial causal coefficient, truncated where the powers of the pole become negligible
+  horizon = int(ceil(log(SPLINE_COEFFICIENT_TOLERANCE) / log(fabs(z))));
+  if (horizon < n) {
+    zn  = z;
+    sum = c[0];
+    for (k = 1; k < horizon; k++) {
+      sum += zn * c[k];
+      zn  *= z;
+    }
+  } else {
+    zn  = z;
+    iz  = 1 / z;
+    z2n = pow(z, n - 1);
+    sum = c[0] + z2n * c[n - 1];
+    z2n *= z2n * iz;
+    for (k = 1; k <= n - 2; k++) {
+      sum += (zn + z2n) * c[k];
+      zn  *= z;
+      z2n *= iz;
+    }
+    sum /= (1 - zn * zn);
+  }
+  c[0] = sum;
+  for (k = 1; k < n; k++) c[k] += z * c[k - 1];
+
+  // Anticausal recursion
+  c[n - 1] = (z / (z * z - 1)) * (z * c[n - 2] + c[n - 1]);
+  for (k = n - 2; k >= 0; k--) c[k] = z * (c[k + 1] - c[k]);
+}
+
+/// Prefiltering of the lines of a frame along one axis
+class SplinePrefilter
+{
+public:
+
+  /// Coefficients of the frame (updated in place)
+  float *_coefficients;
+
+  /// Size of the frame
+  int _x, _y, _z;
+
+  /// Axis along which lines are filtered
+  int _axis;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, k, l, n, stride, offset;
+    std::vector<double> line;
+
+    n      = (_axis == 0) ? _x : ((_axis == 1) ? _y : _z);
+    stride = (_axis == 0) ? 1 : ((_axis == 1) ? _x : _x * _y);
+    line.resize(n);
+    for (l = re.begin(); l != re.end(); l++) {
+      // First voxel of the l-th line
+      if (_axis == 0) {
+        offset = l * _x;
+      } else if (_axis == 1) {
+        offset = (l % _x) + (l / _x) * _x * _y;
+      } else {
+        offset = l;
+      }
+      for (k = 0, i = offset; k < n; k++, i += stride) line[k] = _coefficients[i];
+      PrefilterLine(&line[0], n);
+      for (k = 0, i = offset; k < n; k++, i += stride) _coefficients[i] = line[k];
+    }
+  }
+};
+
+/// Copy of the voxels of a frame
+class SplineFrameCopy
+{
+public:
+
+  /// Image and frame
+  mirtk::Image *_image;
+  int _frame;
+
+  /// Voxels of the frame (output)
+  float *_coefficients;
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, k;
+    float *ptr;
+
+    for (k = re.begin(); k != re.end(); k++) {
+      ptr = _coefficients + k * _image->GetX() * _image->GetY();
+      for (j = 0; j < _image->GetY(); j++) {
+        for (i = 0; i < _image->GetX(); i++, ptr++) {
+          *ptr = _image->GetAsDouble(i, j, k, _frame);
+        }
+      }
+    }
+  }
+};
+
+SplineCoefficientCache::SplineCoefficientCache()
+{
+  _image = NULL;
+  this->SetMemoryLimit(SPLINE_COEFFICIENT_CACHE_MEMORY);
+  this->Clear();
+}
+
+void SplineCoefficientCache::Clear()
+{
+  _image     = NULL;
+  _clock     = 0;
+  _frameSize = 0;
+  std::vector<std::vector<float> >().swap(_coefficients);
+  std::vector<long>().swap(_lastUse);
+}
+
+void SplineCoefficientCache::SetMemoryLimit(int mb)
+{
+  _memoryLimit = mb * 1024.0 * 1024.0;
+}
+
+int SplineCoefficientCache::GetNumberOfFrames() const
+{
+  int i, n;
+
+  n = 0;
+  for (i = 0; i < int(_coefficients.size()); i++) {
+    if (_coefficients[i].empty() == false) n++;
+  }
+  return n;
+}
+
+void SplineCoefficientCache::ComputeFrame(int t)
+{
+  SplineFrameCopy copy;
+  SplinePrefilter body;
+
+  _coefficients[t].resize(_frameSize);
+  copy._image        = _image;
+  copy._frame        = t;
+  copy._coefficients = &_coefficients[t][0];
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, _image->GetZ()), copy);
+
+  // Separable prefilter, the lines along each axis are independent
+  body._coefficients = &_coefficients[t][0];
+  body._x = _image->GetX();
+  body._y = _image->GetY();
+  body._z = _image->GetZ();
+  body._axis = 0;
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, body._y * body._z), body);
+  body._axis = 1;
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, body._x * body._z), body);
+  body._axis = 2;
+  mirtk::parallel_for(mirtk::blocked_range<int>(0, body._x * body._y), body);
+}
+
+const float *SplineCoefficientCache::GetCoefficients(mirtk::Image *image, int t)
+{
+  int i, n, max;
+
+  // Frames of another image, or of one which has been replaced at the same address
+  if ((image != _image) || (_frameSize != image->GetX() * image->GetY() * image->GetZ()) ||
+      (int(_coefficients.size()) != image->GetT())) {
+    this->Clear();
+    _image     = image;
+    _frameSize = image->GetX() * image->GetY() * image->GetZ();
+    _coefficients.resize(image->GetT());
+    _lastUse.assign(image->GetT(), -1);
+  }
+  if ((t < 0) || (t >= int(_coefficients.size()))) return NULL;
+  _lastUse[t] = _clock++;
+  if (_coefficients[t].empty() == false) return &_coefficients[t][0];
+
+  // Discard least recently used frames until the new one fits, it is kept in any case
+  max = int(_memoryLimit / (_frameSize * sizeof(float)));
+  while (this->GetNumberOfFrames() >= max) {
+    n = -1;
+    for (i = 0; i < int(_coefficients.size()); i++) {
+      if ((_coefficients[i].empty() == false) && ((n < 0) || (_lastUse[i] < _lastUse[n]))) n = i;
+    }
+    if (n < 0) break;
+    std::vector<float>().swap(_coefficients[n]);
+  }
+  this->ComputeFrame(t);
+  return &_coefficients[t][0];
+}
+
+double SplineCoefficientCache::Evaluate(const float *c, int nx, int ny, int nz, double x, double y, double z)
+{
+  int a, b, d, i, j, k, u[4], v[4], w[4];
+  double s, t, wx[4], wy[4], wz[4], value, row, plane;
+
+  i = int(floor(x));
+  j = int(floor(y));
+  k = int(floor(z));
+
+  // Cubic B-spline weights of the four samples around each coordinate
+  s = x - i;
+  t = 1 - s;
+  wx[0] = t * t * t / 6.0;
+  wx[1] = (3 * s * s * s - 6 * s * s + 4) / 6.0;
+  wx[2] = (-3 * s * s * s + 3 * s * s + 3 * s + 1) / 6.0;
+  wx[3] = s * s * s / 6.0;
+  s = y - j;
+  t = 1 - s;
+  wy[0] = t * t * t / 6.0;
+  wy[1] = (3 * s * s * s - 6 * s * s + 4) / 6.0;
+  wy[2] = (-3 * s * s * s + 3 * s * s + 3 * s + 1) / 6.0;
+  wy[3] = s * s * s / 6.0;
+  s = z - k;
+  t = 1 - s;
+  wz[0] = t * t * t / 6.0;
+  wz[1] = (3 * s * s * s - 6 * s * s + 4) / 6.0;
+  wz[2] = (-3 * s * s * s + 3 * s * s + 3 * s + 1) / 6.0;
+  wz[3] = s * s * s / 6.0;
+  for (a = 0; a < 4; a++) {
+    u[a] = MirrorIndex(i - 1 + a, nx);
+    v[a] = MirrorIndex(j - 1 + a, ny) * nx;
+    w[a] = MirrorIndex(k - 1 + a, nz) * nx * ny;
+  }
+
+  value = 0;
+  for (d = 0; d < 4; d++) {
+    if (wz[d] == 0) continue;
+    plane = 0;
+    for (b = 0; b < 4; b++) {
+      row = 0;
+      for (a = 0; a < 4; a++) row += wx[a] * c[w[d] + v[b] + u[a]];
+      plane += wy[b] * row;
+    }
+    value += wz[d] * plane;
+  }
+  return value;
+}
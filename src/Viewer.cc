@@ -13,6 +13,7 @@
 #include <mirtk/Image.h>
 #include <mirtk/Transformation.h>
 #include <mirtk/Registration.h>
+#include <mirtk/Parallel.h>
 
 #ifdef __APPLE__
 #include <OpenGl/gl.h>
@@ -24,45 +25,11 @@
 
 #include <RView.h>
 
-// Define the maximum number of control points along each axis we can
-// handle here.
-
-#define MaxNumberOfCP 1000
-
-// Define some global variables. These variables should NOT be used by
-// any other classes. Perhaps they should be static members.
-
-static int _NumberOfX;
-static int _NumberOfY;
-static double _BeforeX[MaxNumberOfCP][MaxNumberOfCP];
-static double _BeforeY[MaxNumberOfCP][MaxNumberOfCP];
-static double _BeforeZ[MaxNumberOfCP][MaxNumberOfCP];
-static double _AfterX[MaxNumberOfCP][MaxNumberOfCP];
-static double _AfterY[MaxNumberOfCP][MaxNumberOfCP];
-static double _AfterZ[MaxNumberOfCP][MaxNumberOfCP];
-static double _AfterGridX[MaxNumberOfCP][MaxNumberOfCP];
-static double _AfterGridY[MaxNumberOfCP][MaxNumberOfCP];
-static double _AfterGridZ[MaxNumberOfCP][MaxNumberOfCP];
-static mirtk::Transformation::DOFStatus _CPStatus[MaxNumberOfCP][MaxNumberOfCP];
-
-static int _NumberOfTagGridX;
-static int _NumberOfTagGridY;
-static double _AfterTagGridX [MaxNumberOfCP][MaxNumberOfCP];
-static double _AfterTagGridY [MaxNumberOfCP][MaxNumberOfCP];
-static double _AfterTagGridZ [MaxNumberOfCP][MaxNumberOfCP];
-static double _BeforeTagGridX[MaxNumberOfCP][MaxNumberOfCP];
-static double _BeforeTagGridY[MaxNumberOfCP][MaxNumberOfCP];
-static double _BeforeTagGridZ[MaxNumberOfCP][MaxNumberOfCP];
+#include <map>
 
 // Define the default color scheme
-#define COLOR_GRID                        glColor3f(1, 1, 0)
-#define COLOR_ARROWS                      glColor3f(1, 1, 0)
-#define COLOR_ISOLINES                    glColor3f(1, 1, 0)
 #define COLOR_CONTOUR                     glColor4f(0, 1, 0, 0.5)
 #define COLOR_CURSOR                      glColor3f(0, 1, 0)
-#define COLOR_POINTS_ACTIVE               glColor3f(0, 1, 0)
-#define COLOR_POINTS_PASSIVE              glColor3f(0, 0, 1)
-#define COLOR_POINTS_UNKNOWN              glColor3f(1, 1, 0)
 #define COLOR_CONTOUR_1                   glColor3f(1, 0, 0)
 #define COLOR_CONTOUR_2                   glColor3f(0, 1, 0)
 #define COLOR_CONTOUR_3                   glColor3f(0, 0, 1)
@@ -73,6 +40,14 @@ static double _BeforeTagGridZ[MaxNumberOfCP][MaxNumberOfCP];
 #define COLOR_SELECTED_TARGET_LANDMARKS   glColor3f(1, 1, 0)
 #define COLOR_SELECTED_SOURCE_LANDMARKS   glColor3f(0, 1, 1)
 
+// Same colors as unsigned char triplets for retained overlays
+#define RGB_GRID                          255, 255, 0
+#define RGB_ARROWS                        255, 255, 0
+#define RGB_ISOLINES                      255, 255, 0
+#define RGB_POINTS_ACTIVE                 0, 255, 0
+#define RGB_POINTS_PASSIVE                0, 0, 255
+#define RGB_POINTS_UNKNOWN                255, 255, 0
+
 #ifdef HAS_VTK
 
 // vtk includes
@@ -152,18 +127,18 @@ GLubyte letters[][13] =
 GLuint fontOffset;
 
 // Little helper(s)
-void status_glColor(int status)
+void status_color(int status, Overlay &overlay)
 {
 	switch (status)
 	{
 	case mirtk::Status::Active:
-		COLOR_POINTS_ACTIVE;
+		overlay.SetColor(RGB_POINTS_ACTIVE);
 		break;
 	case mirtk::Status::Passive:
-		COLOR_POINTS_PASSIVE;
+		overlay.SetColor(RGB_POINTS_PASSIVE);
 		break;
 	default:
-		COLOR_POINTS_UNKNOWN;
+		overlay.SetColor(RGB_POINTS_UNKNOWN);
 		break;
 	}
 }
@@ -184,10 +159,32 @@ Viewer::Viewer(RView *rview, ViewerMode viewerMode)
 
 	// Mode of image viewer
 	_viewerMode = viewerMode;
+
+	// No texture yet
+	_texture = 0;
+	_textureWidth = 0;
+	_textureHeight = 0;
+	_textureX = 0;
+	_textureY = 0;
+	_textureBuffer = NULL;
+
+	// No retained overlays yet
+	_isolinesImage[0] = NULL;
+	_isolinesImage[1] = NULL;
+	_deformationVersion = 0;
+	_tagGridVersion = 0;
+
+	// No (control) points yet
+	_NumberOfX = 0;
+	_NumberOfY = 0;
+	_NumberOfTagGridX = 0;
+	_NumberOfTagGridY = 0;
 }
 
 Viewer::~Viewer()
 {
+	if (_texture != 0) glDeleteTextures(1, &_texture);
+	delete[] _textureBuffer;
 }
 
 bool Viewer::UpdateTagGrid(mirtk::GreyImage *image, mirtk::Transformation *transformation, mirtk::PointSet landmark)
@@ -198,7 +195,7 @@ bool Viewer::UpdateTagGrid(mirtk::GreyImage *image, mirtk::Transformation *trans
   mirtk::MultiLevelTransformation *mffd = NULL;
   mirtk::Point p1, p2;
   double dx1, dy1, dx2, dy2, dz, x, y, tt, ts;
-  int i, k, k1, k2, m, n;
+  int i, k, k1, k2, m, n, p;
 
   // Convert landmarks to image coordinates
   for (i = 0; i < landmark.Size(); i++) image->WorldToImage(landmark(i));
@@ -232,6 +229,12 @@ bool Viewer::UpdateTagGrid(mirtk::GreyImage *image, mirtk::Transformation *trans
 
   _NumberOfTagGridX = 13;
   _NumberOfTagGridY = 13;
+  _BeforeTagGridX.resize(_NumberOfTagGridX * _NumberOfTagGridY);
+  _BeforeTagGridY.resize(_NumberOfTagGridX * _NumberOfTagGridY);
+  _BeforeTagGridZ.resize(_NumberOfTagGridX * _NumberOfTagGridY);
+  _AfterTagGridX .resize(_NumberOfTagGridX * _NumberOfTagGridY);
+  _AfterTagGridY .resize(_NumberOfTagGridX * _NumberOfTagGridY);
+  _AfterTagGridZ .resize(_NumberOfTagGridX * _NumberOfTagGridY);
 
   dx1 = (landmark(1)._x - landmark(0)._x) / 12.0;
   dy1 = (landmark(1)._y - landmark(0)._y) / 12.0;
@@ -246,29 +249,33 @@ bool Viewer::UpdateTagGrid(mirtk::GreyImage *image, mirtk::Transformation *trans
       for (n = 0; n < 13; n++) {
         x = landmark(0)._x + dx1 * n + dx2 * m;
         y = landmark(0)._y + dy1 * n + dy2 * m;
+        p = m + n * _NumberOfTagGridX;
 
-        _BeforeTagGridX[m][n] = x;
-        _BeforeTagGridY[m][n] = y;
-        _BeforeTagGridZ[m][n] = k;
-        image->ImageToWorld(_BeforeTagGridX[m][n], _BeforeTagGridY[m][n], _BeforeTagGridZ[m][n]);
+        _BeforeTagGridX[p] = x;
+        _BeforeTagGridY[p] = y;
+        _BeforeTagGridZ[p] = k;
+        image->ImageToWorld(_BeforeTagGridX[p], _BeforeTagGridY[p], _BeforeTagGridZ[p]);
 
-        _AfterTagGridX[m][n] = _BeforeTagGridX[m][n];
-        _AfterTagGridY[m][n] = _BeforeTagGridY[m][n];
-        _AfterTagGridZ[m][n] = _BeforeTagGridZ[m][n];
+        _AfterTagGridX[p] = _BeforeTagGridX[p];
+        _AfterTagGridY[p] = _BeforeTagGridY[p];
+        _AfterTagGridZ[p] = _BeforeTagGridZ[p];
         if (_rview->GetSourceTransformApply()) {
           if (mffd != NULL) {
-            mffd->LocalTransform(_AfterTagGridX[m][n], _AfterTagGridY[m][n], _AfterTagGridZ[m][n], ts, tt);
+            mffd->LocalTransform(_AfterTagGridX[p], _AfterTagGridY[p], _AfterTagGridZ[p], ts, tt);
           } else if (affd != NULL) {
-            affd->Transform     (_AfterTagGridX[m][n], _AfterTagGridY[m][n], _AfterTagGridZ[m][n], ts, tt);
+            affd->Transform     (_AfterTagGridX[p], _AfterTagGridY[p], _AfterTagGridZ[p], ts, tt);
           }
         }
 
-        image->WorldToImage(_BeforeTagGridX[m][n], _BeforeTagGridY[m][n], _BeforeTagGridZ[m][n]);
-        image->WorldToImage(_AfterTagGridX [m][n], _AfterTagGridY [m][n], _AfterTagGridZ [m][n]);
+        image->WorldToImage(_BeforeTagGridX[p], _BeforeTagGridY[p], _BeforeTagGridZ[p]);
+        image->WorldToImage(_AfterTagGridX [p], _AfterTagGridY [p], _AfterTagGridZ [p]);
       }
     }
   }
 
+  // Retained tag grid needs to be rebuilt
+  _tagGridVersion++;
+
   return true;
 }
 
@@ -276,13 +283,7 @@ bool Viewer::Update1(mirtk::GreyImage *image, mirtk::MultiLevelTransformation *m
 {
 	double x1, y1, z1, x2, y2, z2;
 	int    i1, j1, k1, i2, j2, k2;
-	int    index, i, j, k, m, n;
-
-  // Check number of control points
-  if ((affd->GetX() >= MaxNumberOfCP) || (affd->GetY() >= MaxNumberOfCP) || (affd->GetZ() >= MaxNumberOfCP)) {
-    std::cerr << "Transformation has too many control points" << std::endl;
-    exit(1);
-  }
+	int    index, i, j, k, m, n, p;
 
 	// Find out first corner of ROI
 	x1 = 0;
@@ -340,6 +341,7 @@ bool Viewer::Update1(mirtk::GreyImage *image, mirtk::MultiLevelTransformation *m
 	default:
 		break;
 	}
+	this->AllocatePoints();
 
 	for (k = k1; k <= k2; k++) {
 		for (j = j1; j <= j2; j++) {
@@ -364,47 +366,48 @@ bool Viewer::Update1(mirtk::GreyImage *image, mirtk::MultiLevelTransformation *m
 					n = j;
 					break;
 				}
+				p = m + n * _NumberOfX;
 
-				_BeforeX[m][n] = i;
-				_BeforeY[m][n] = j;
-				_BeforeZ[m][n] = k;
-				affd->LatticeToWorld(_BeforeX[m][n], _BeforeY[m][n], _BeforeZ[m][n]);
+				_BeforeX[p] = i;
+				_BeforeY[p] = j;
+				_BeforeZ[p] = k;
+				affd->LatticeToWorld(_BeforeX[p], _BeforeY[p], _BeforeZ[p]);
 
-				_AfterX[m][n] = _BeforeX[m][n];
-				_AfterY[m][n] = _BeforeY[m][n];
-				_AfterZ[m][n] = _BeforeZ[m][n];
+				_AfterX[p] = _BeforeX[p];
+				_AfterY[p] = _BeforeY[p];
+				_AfterZ[p] = _BeforeZ[p];
 				if (mffd != NULL) {
           if (_rview->GetDisplayDeformationTotal()) {
             if (_rview->GetSourceTransformInvert()) {
-              mffd->Inverse  (_AfterX[m][n], _AfterY[m][n], _AfterZ[m][n], ts, tt);
+              _rview->InverseTransform(_AfterX[p], _AfterY[p], _AfterZ[p]);
             } else {
-              mffd->Transform(_AfterX[m][n], _AfterY[m][n], _AfterZ[m][n], ts, tt);
+              _rview->Transform(_AfterX[p], _AfterY[p], _AfterZ[p]);
             }
           } else {
             if (_rview->GetSourceTransformInvert()) {
-              mffd->LocalInverse  (_AfterX[m][n], _AfterY[m][n], _AfterZ[m][n], ts, tt);
+              mffd->LocalInverse  (_AfterX[p], _AfterY[p], _AfterZ[p], ts, tt);
             } else {
-              mffd->LocalTransform(_AfterX[m][n], _AfterY[m][n], _AfterZ[m][n], ts, tt);
+              mffd->LocalTransform(_AfterX[p], _AfterY[p], _AfterZ[p], ts, tt);
             }
           }
         } else {
           if (_rview->GetSourceTransformInvert()) {
-            affd->Inverse  (_AfterX[m][n], _AfterY[m][n], _AfterZ[m][n], ts, tt);
+            _rview->InverseTransform(_AfterX[p], _AfterY[p], _AfterZ[p]);
           } else {
-            affd->Transform(_AfterX[m][n], _AfterY[m][n], _AfterZ[m][n], ts, tt);
+            _rview->Transform(_AfterX[p], _AfterY[p], _AfterZ[p]);
           }
         }
 
-				image->WorldToImage(_BeforeX[m][n], _BeforeY[m][n], _BeforeZ[m][n]);
-				image->WorldToImage(_AfterX[m][n], _AfterY[m][n], _AfterZ[m][n]);
+				image->WorldToImage(_BeforeX[p], _BeforeY[p], _BeforeZ[p]);
+				image->WorldToImage(_AfterX[p], _AfterY[p], _AfterZ[p]);
 
 				index = affd->LatticeToIndex(i, j, k);
-        _CPStatus[m][n] = affd->IsActive(index) ? mirtk::Status::Active : mirtk::Status::Passive;
+        _CPStatus[p] = affd->IsActive(index) ? mirtk::Status::Active : mirtk::Status::Passive;
 
 #ifdef HAVE__CPLABEL
-				_CPLabel[m][n] = affd->GetLabel(index);
-				if (_CPLabel[m][n] > _CPMaxLabel) _CPMaxLabel = _CPLabel[m][n];
-				if (_CPLabel[m][n] < _CPMinLabel) _CPMinLabel = _CPLabel[m][n];
+				_CPLabel[p] = affd->GetLabel(index);
+				if (_CPLabel[p] > _CPMaxLabel) _CPMaxLabel = _CPLabel[p];
+				if (_CPLabel[p] < _CPMinLabel) _CPMinLabel = _CPLabel[p];
 #endif
 
 			}
@@ -417,55 +420,60 @@ bool Viewer::Update1(mirtk::GreyImage *image, mirtk::MultiLevelTransformation *m
 bool Viewer::Update2(mirtk::GreyImage *image, mirtk::MultiLevelTransformation *mffd, mirtk::FreeFormTransformation *affd, double ts, double tt)
 {
 	double dx, dy;
-	int    i, j;
+	int    i, j, p;
 
 	dx = _rview->_DisplayDeformationGridResolution;
 	dy = _rview->_DisplayDeformationGridResolution;
 	_NumberOfX = round(static_cast<double>(this->GetWidth()  - 40) / dx);
 	_NumberOfY = round(static_cast<double>(this->GetHeight() - 40) / dy);
+	// Viewers smaller than the margin have no grid points
+	if (_NumberOfX < 0) _NumberOfX = 0;
+	if (_NumberOfY < 0) _NumberOfY = 0;
 	dx = (this->GetWidth()  - 40) / static_cast<double>(_NumberOfX);
 	dy = (this->GetHeight() - 40) / static_cast<double>(_NumberOfY);
+	this->AllocatePoints();
 
 	for (j = 0; j < _NumberOfY; j++) {
 		for (i = 0; i < _NumberOfX; i++) {
-			_BeforeX[i][j] = i * dx + 20 + dx / 2.0;
-			_BeforeY[i][j] = j * dy + 20 + dy / 2.0;
-			_BeforeZ[i][j] = 0;
-			_AfterX [i][j] = _BeforeX[i][j];
-			_AfterY [i][j] = _BeforeY[i][j];
-			_AfterZ [i][j] = 0;
+			p = i + j * _NumberOfX;
+			_BeforeX[p] = i * dx + 20 + dx / 2.0;
+			_BeforeY[p] = j * dy + 20 + dy / 2.0;
+			_BeforeZ[p] = 0;
+			_AfterX [p] = _BeforeX[p];
+			_AfterY [p] = _BeforeY[p];
+			_AfterZ [p] = 0;
 
-			image->ImageToWorld(_AfterX[i][j], _AfterY[i][j], _AfterZ[i][j]);
+			image->ImageToWorld(_AfterX[p], _AfterY[p], _AfterZ[p]);
 
 			if (mffd != NULL) {
         if (_rview->GetDisplayDeformationTotal()) {
           if (_rview->GetSourceTransformInvert()) {
-            mffd->Inverse  (_AfterX[i][j], _AfterY[i][j], _AfterZ[i][j], ts, tt);
+            _rview->InverseTransform(_AfterX[p], _AfterY[p], _AfterZ[p]);
           } else {
-            mffd->Transform(_AfterX[i][j], _AfterY[i][j], _AfterZ[i][j], ts, tt);
+            _rview->Transform(_AfterX[p], _AfterY[p], _AfterZ[p]);
           }
         } else {
           if (_rview->GetSourceTransformInvert()) {
-            mffd->LocalInverse  (_AfterX[i][j], _AfterY[i][j], _AfterZ[i][j], ts, tt);
+            mffd->LocalInverse  (_AfterX[p], _AfterY[p], _AfterZ[p], ts, tt);
           } else {
-            mffd->LocalTransform(_AfterX[i][j], _AfterY[i][j], _AfterZ[i][j], ts, tt);
+            mffd->LocalTransform(_AfterX[p], _AfterY[p], _AfterZ[p], ts, tt);
           }
         }
 			} else {
 				if (_rview->GetSourceTransformInvert()) {
-					affd->Inverse  (_AfterX[i][j], _AfterY[i][j], _AfterZ[i][j], ts, tt);
+					_rview->InverseTransform(_AfterX[p], _AfterY[p], _AfterZ[p]);
 				} else {
-					affd->Transform(_AfterX[i][j], _AfterY[i][j], _AfterZ[i][j], ts, tt);
+					_rview->Transform(_AfterX[p], _AfterY[p], _AfterZ[p]);
 				}
 			}
 
-			image->WorldToImage(_AfterX[i][j], _AfterY[i][j], _AfterZ[i][j]);
+			image->WorldToImage(_AfterX[p], _AfterY[p], _AfterZ[p]);
 
 			//
 			// FIXME was 
-			// _CPStatus[i][j] = _Unknown;
+			// _CPStatus[p] = _Unknown;
 			//
-			_CPStatus[i][j] = mirtk::Status::Passive;
+			_CPStatus[p] = mirtk::Status::Passive;
 		}
 	}
 
@@ -482,6 +490,7 @@ bool Viewer::Update(mirtk::GreyImage *image, mirtk::Transformation *transformati
   if (mffd == NULL && affd == NULL) {
     _NumberOfX = 0;
     _NumberOfY = 0;
+    _deformationKey.clear();
     return false;
   }
 
@@ -501,6 +510,35 @@ bool Viewer::Update(mirtk::GreyImage *image, mirtk::Transformation *transformati
     ts = affd->LatticeToTime(affd->GetT() - 1);
   }
 
+  // Reuse points until the plane, transformation, time or display settings change
+  std::vector<double> key;
+  double x, y, z;
+  for (int i = 0; i < 3; i++) {
+    x = (i == 1) ? 1 : 0;
+    y = (i == 2) ? 1 : 0;
+    z = 0;
+    image->ImageToWorld(x, y, z);
+    key.push_back(x);
+    key.push_back(y);
+    key.push_back(z);
+  }
+  key.push_back(image->GetX());
+  key.push_back(image->GetY());
+  key.push_back(this->GetWidth());
+  key.push_back(this->GetHeight());
+  key.push_back(_viewerMode);
+  key.push_back(_rview->GetSourceTransformVersion());
+  key.push_back(ts);
+  key.push_back(tt);
+  key.push_back(_rview->GetSourceTransformInvert());
+  key.push_back(_rview->GetSourceTransformApply());
+  key.push_back(_rview->GetDisplayDeformationTotal());
+  key.push_back(_rview->GetDisplayDeformationGrid());
+  key.push_back(_rview->GetViewMode() == View_B);
+  key.push_back(_rview->_DisplayDeformationGridResolution);
+  if (key == _deformationKey) return true;
+  _deformationKey.clear();
+
   // Compute (control) points before and after transformation
   // (application of mirtk::Transformation::Transform or mirtk::Transformation::Inverse)
   bool ok = false;
@@ -511,63 +549,72 @@ bool Viewer::Update(mirtk::GreyImage *image, mirtk::Transformation *transformati
   }
   if (!ok) return false;
 
+  // Retained deformation overlays need to be rebuilt
+  _deformationVersion++;
+  _deformationKey.swap(key);
+
   // Deformation grid visualization
   if (_rview->GetDisplayDeformationGrid()) {
     // Copy points before transformation (space of target image)
-    for (int j = 0; j < _NumberOfY; j++) {
-      for (int i = 0; i < _NumberOfX; i++) {
-        _AfterGridX[i][j] = _BeforeX[i][j];
-        _AfterGridY[i][j] = _BeforeY[i][j];
-        _AfterGridZ[i][j] = _BeforeZ[i][j];
-      }
-    }
+    _AfterGridX = _BeforeX;
+    _AfterGridY = _BeforeY;
+    _AfterGridZ = _BeforeZ;
     // If source image is being viewed, however, ...
     if (_rview->GetViewMode() == View_B) {
       // ... and if transformation is being applied, show inverse deformed grid
       if (_rview->GetSourceTransformApply()) {
-        for (int j = 0; j < _NumberOfY; j++) {
-          for (int i = 0; i < _NumberOfX; i++) {
-            image->ImageToWorld(_AfterGridX[i][j], _AfterGridY[i][j], _AfterGridZ[i][j]);
-            if (mffd != NULL) {
-              if (_rview->GetDisplayDeformationTotal()) {
-                if (_rview->GetSourceTransformInvert()) {
-                  mffd->Transform(_AfterGridX[i][j], _AfterGridY[i][j], _AfterGridZ[i][j], tt, ts);
-                } else {
-                  mffd->Inverse  (_AfterGridX[i][j], _AfterGridY[i][j], _AfterGridZ[i][j], tt, ts);
-                }
+        for (int p = 0; p < _NumberOfX * _NumberOfY; p++) {
+          image->ImageToWorld(_AfterGridX[p], _AfterGridY[p], _AfterGridZ[p]);
+          if (mffd != NULL) {
+            if (_rview->GetDisplayDeformationTotal()) {
+              if (_rview->GetSourceTransformInvert()) {
+                _rview->Transform(_AfterGridX[p], _AfterGridY[p], _AfterGridZ[p]);
               } else {
-                if (_rview->GetSourceTransformInvert()) {
-                  mffd->LocalTransform(_AfterGridX[i][j], _AfterGridY[i][j], _AfterGridZ[i][j], tt, ts);
-                } else {
-                  mffd->LocalInverse  (_AfterGridX[i][j], _AfterGridY[i][j], _AfterGridZ[i][j], tt, ts);
-                }
+                _rview->InverseTransform(_AfterGridX[p], _AfterGridY[p], _AfterGridZ[p]);
               }
             } else {
               if (_rview->GetSourceTransformInvert()) {
-                affd->Transform(_AfterGridX[i][j], _AfterGridY[i][j], _AfterGridZ[i][j], tt, ts);
+                mffd->LocalTransform(_AfterGridX[p], _AfterGridY[p], _AfterGridZ[p], tt, ts);
               } else {
-                affd->Inverse  (_AfterGridX[i][j], _AfterGridY[i][j], _AfterGridZ[i][j], tt, ts);
+                mffd->LocalInverse  (_AfterGridX[p], _AfterGridY[p], _AfterGridZ[p], tt, ts);
               }
             }
-            image->WorldToImage(_AfterGridX[i][j], _AfterGridY[i][j], _AfterGridZ[i][j]);
+          } else {
+            if (_rview->GetSourceTransformInvert()) {
+              _rview->Transform(_AfterGridX[p], _AfterGridY[p], _AfterGridZ[p]);
+            } else {
+              _rview->InverseTransform(_AfterGridX[p], _AfterGridY[p], _AfterGridZ[p]);
+            }
           }
+          image->WorldToImage(_AfterGridX[p], _AfterGridY[p], _AfterGridZ[p]);
         }
       }
     } else {
       // By default, just copy points after transformation (space of source image)
-      for (int j = 0; j < _NumberOfY; j++) {
-        for (int i = 0; i < _NumberOfX; i++) {
-          _AfterGridX[i][j] = _AfterX[i][j];
-          _AfterGridY[i][j] = _AfterY[i][j];
-          _AfterGridZ[i][j] = _AfterZ[i][j];
-        }
-      }
+      _AfterGridX = _AfterX;
+      _AfterGridY = _AfterY;
+      _AfterGridZ = _AfterZ;
     }
   }
 
   return true;
 }
 
+void Viewer::AllocatePoints()
+{
+  int n;
+
+  // Resizing keeps the allocated capacity, so buffers are reused between frames
+  n = _NumberOfX * _NumberOfY;
+  _BeforeX .resize(n);
+  _BeforeY .resize(n);
+  _BeforeZ .resize(n);
+  _AfterX  .resize(n);
+  _AfterY  .resize(n);
+  _AfterZ  .resize(n);
+  _CPStatus.resize(n);
+}
+
 void Viewer::DrawCursor(CursorMode mode)
 {
 	int x, y;
@@ -618,151 +665,361 @@ void Viewer::DrawCursor(CursorMode mode)
 	}
 }
 
-void Viewer::DrawIsolines(mirtk::GreyImage *image, int value)
+// Edges of a marching squares cell which are crossed by an isoline, indexed
+// by the corners above the iso-value: 1 = (i, j), 2 = (i+1, j), 4 = (i+1, j+1),
+// 8 = (i, j+1). Edges are 0 = bottom, 1 = right, 2 = top and 3 = left. The two
+// ambiguous cases 5 and 10 are listed for a cell centre below the iso-value.
+static const int MarchingSquaresEdges[16][5] = {
+  {-1, -1, -1, -1, -1}, { 3,  0, -1, -1, -1}, { 0,  1, -1, -1, -1},
+  { 3,  1, -1, -1, -1}, { 1,  2, -1, -1, -1}, { 3,  0,  1,  2, -1},
+  { 0,  2, -1, -1, -1}, { 3,  2, -1, -1, -1}, { 2,  3, -1, -1, -1},
+  { 0,  2, -1, -1, -1}, { 0,  1,  2,  3, -1}, { 1,  2, -1, -1, -1},
+  { 3,  1, -1, -1, -1}, { 0,  1, -1, -1, -1}, { 3,  0, -1, -1, -1},
+  {-1, -1, -1, -1, -1}
+};
+
+/// Marching squares on the rows of a plane for a set of iso-values
+class MarchingSquares
 {
-	int i, j;
 
-	// Set color
-	COLOR_ISOLINES;
-	glLineWidth(_rview->GetLineThickness());
-	glBegin (GL_LINES);
+public:
+
+  /// Voxels of plane
+  const mirtk::GreyPixel *_voxels;
+
+  /// Size of plane
+  int _x, _y;
+
+  /// Iso-values
+  const double *_values;
+
+  /// Number of iso-values
+  int _n;
+
+  /// Line segments (x1, y1, x2, y2) found in each row of cells
+  std::vector<float> *_rows;
+
+  /// Compute position of isoline on the given edge of cell (i, j)
+  void Crossing(int i, int j, int edge, double value, double v[4], float &x, float &y) const
+  {
+    switch (edge) {
+      case 0:
+        x = i + (value - v[0]) / (v[1] - v[0]);
+        y = j;
+        break;
+      case 1:
+        x = i + 1;
+        y = j + (value - v[1]) / (v[2] - v[1]);
+        break;
+      case 2:
+        x = i + (value - v[3]) / (v[2] - v[3]);
+        y = j + 1;
+        break;
+      default:
+        x = i;
+        y = j + (value - v[0]) / (v[3] - v[0]);
+        break;
+    }
+    // Voxel centres are in the middle of the pixels
+    x += 0.5;
+    y += 0.5;
+  }
 
-	for (j = 0; j < this->GetHeight() - 1; j++) {
-		for (i = 0; i < this->GetWidth() - 1; i++) {
-			if (((image->Get(i, j, 0) <= value) && (image->Get(i + 1, j, 0) > value))
-					|| ((image->Get(i, j, 0) > value)
-							&& (image->Get(i + 1, j, 0) <= value))) {
-				glVertex2f(_screenX1 + i + 0.5, _screenY1 + j - 0.5);
-				glVertex2f(_screenX1 + i + 0.5, _screenY1 + j + 0.5);
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int i, j, l, m, c;
+    double v[4];
+    float x, y;
+    const mirtk::GreyPixel *ptr;
+
+    for (j = re.begin(); j != re.end(); ++j) {
+      std::vector<float> &row = _rows[j];
+      row.clear();
+      ptr = _voxels + j * _x;
+      for (i = 0; i < _x - 1; i++, ptr++) {
+        v[0] = ptr[0];
+        v[1] = ptr[1];
+        v[2] = ptr[_x + 1];
+        v[3] = ptr[_x];
+        for (l = 0; l < _n; l++) {
+          c = 0;
+          if (v[0] > _values[l]) c |= 1;
+          if (v[1] > _values[l]) c |= 2;
+          if (v[2] > _values[l]) c |= 4;
+          if (v[3] > _values[l]) c |= 8;
+          if ((c == 0) || (c == 15)) continue;
+          // Resolve ambiguous cases using the cell centre
+          if (((c == 5) || (c == 10)) && ((v[0] + v[1] + v[2] + v[3]) / 4.0 > _values[l])) {
+            c = 15 - c;
+          }
+          for (m = 0; MarchingSquaresEdges[c][m] >= 0; m++) {
+            this->Crossing(i, j, MarchingSquaresEdges[c][m], _values[l], v, x, y);
+            row.push_back(x);
+            row.push_back(y);
+          }
+        }
+      }
+    }
+  }
 
+};
+
+void Viewer::DrawIsolines(mirtk::GreyImage *image, int n, const double *values, int version)
+{
+	int j, l;
+	double key[3 + MAX_ISOLINES];
+	Overlay *overlay;
+
+	if (n > MAX_ISOLINES) n = MAX_ISOLINES;
+
+	// Each viewer shows isolines of at most two images
+	l = ((_isolinesImage[0] == NULL) || (_isolinesImage[0] == image)) ? 0 : 1;
+	_isolinesImage[l] = image;
+	overlay = &_isolines[l];
+
+	// Rebuild isolines only if the image or iso-values changed
+	key[0] = version;
+	key[1] = image->GetX();
+	key[2] = image->GetY();
+	for (l = 0; l < n; l++) key[3+l] = values[l];
+	if (overlay->IsValid(3 + n, key) == false) {
+		overlay->Begin(GL_LINES, 3 + n, key);
+		overlay->SetColor(RGB_ISOLINES);
+		if ((image->GetX() > 1) && (image->GetY() > 1)) {
+			std::vector<float> *rows = new std::vector<float>[image->GetY() - 1];
+
+			// Extract line segments of each row of cells in parallel
+			MarchingSquares body;
+			body._voxels = image->GetPointerToVoxels();
+			body._x      = image->GetX();
+			body._y      = image->GetY();
+			body._values = values;
+			body._n      = n;
+			body._rows   = rows;
+			mirtk::parallel_for(mirtk::blocked_range<int>(0, image->GetY() - 1), body);
+
+			for (j = 0; j < image->GetY() - 1; j++) {
+				if (rows[j].size() > 0) overlay->AddVertices(rows[j].size() / 2, &rows[j][0]);
 			}
-			if (((image->Get(i, j, 0) <= value) && (image->Get(i, j + 1, 0) > value))
-					|| ((image->Get(i, j, 0) > value)
-							&& (image->Get(i, j + 1, 0) <= value))) {
-				glVertex2f(_screenX1 + i + 0.5, _screenY1 + j + 0.5);
-				glVertex2f(_screenX1 + i - 0.5, _screenY1 + j + 0.5);
-			}
+			delete[] rows;
 		}
 	}
-	glEnd();
+
+	glLineWidth(_rview->GetLineThickness());
+	overlay->Draw(_screenX1, _screenY1);
 	glLineWidth(1);
 }
 
-void Viewer::DrawSegmentationContour(mirtk::GreyImage *image)
+/// Boundary segment of a label
+struct LabelBoundarySegment
 {
-	int i, j;
-	unsigned char r, g, b;
-	glLineWidth(_rview->GetLineThickness());
+  int   _label;
+  float _x1, _y1, _x2, _y2;
+};
 
-	for (j = 1; j < this->GetHeight() - 1; j++) {
-		for (i = 1; i < this->GetWidth() - 1; i++) {
-			if ((image->Get(i, j, 0) > 0)
-					&& (_rview->_segmentTable->_entry[image->Get(i, j, 0)]._visible
-							== true)) {
-				r = _rview->_segmentTable->_entry[image->Get(i, j, 0)]._color.r;
-				g = _rview->_segmentTable->_entry[image->Get(i, j, 0)]._color.g;
-				b = _rview->_segmentTable->_entry[image->Get(i, j, 0)]._color.b;
-				if (image->Get(i, j, 0) != image->Get(i + 1, j, 0)) {
-					glColor3ub(r, g, b);
-					glBegin (GL_LINES);
-					glVertex2f(_screenX1 + i, _screenY1 + j - 0.5);
-					glVertex2f(_screenX1 + i, _screenY1 + j + 0.5);
-					glEnd();
-				}
-				if (image->Get(i, j, 0) != image->Get(i - 1, j, 0)) {
-					glColor3ub(r, g, b);
-					glBegin (GL_LINES);
-					glVertex2f(_screenX1 + i, _screenY1 + j - 0.5);
-					glVertex2f(_screenX1 + i, _screenY1 + j + 0.5);
-					glEnd();
-				}
-				if (image->Get(i, j, 0) != image->Get(i, j + 1, 0)) {
-					glColor3ub(r, g, b);
-					glBegin (GL_LINES);
-					glVertex2f(_screenX1 + i + 0.5, _screenY1 + j);
-					glVertex2f(_screenX1 + i - 0.5, _screenY1 + j);
-					glEnd();
-				}
-				if (image->Get(i, j, 0) != image->Get(i, j - 1, 0)) {
-					glColor3ub(r, g, b);
-					glBegin (GL_LINES);
-					glVertex2f(_screenX1 + i + 0.5, _screenY1 + j);
-					glVertex2f(_screenX1 + i - 0.5, _screenY1 + j);
-					glEnd();
+/// Extraction of label boundaries along rows (or columns) of a plane
+class LabelBoundaries
+{
+
+public:
+
+  /// Voxels of plane
+  const int *_voxels;
+
+  /// Size of plane
+  int _x, _y;
+
+  /// Whether to extract vertical boundaries along columns instead of rows
+  bool _vertical;
+
+  /// Segment table
+  SegmentTable *_table;
+
+  /// Boundary segments found in each row (or column)
+  std::vector<LabelBoundarySegment> *_segments;
+
+  /// Label at position t along row (or column) s, 0 outside of plane
+  int Label(int t, int s) const
+  {
+    if (_vertical) std::swap(t, s);
+    if ((t < 0) || (t >= _x) || (s < 0) || (s >= _y)) return 0;
+    return _voxels[s * _x + t];
+  }
+
+  void operator()(const mirtk::blocked_range<int> &re) const
+  {
+    int s, t, t0, n, side, label;
+    LabelBoundarySegment segment;
+
+    n = (_vertical) ? _y : _x;
+    for (s = re.begin(); s != re.end(); ++s) {
+      std::vector<LabelBoundarySegment> &segments = _segments[s];
+      segments.clear();
+      // Boundaries towards the previous (side = 0) and next (side = 1) row
+      for (side = 0; side < 2; side++) {
+        for (t = 0; t < n; t++) {
+          label = this->Label(t, s);
+          if ((label <= 0) || (_table->GetVisibility(label) != true)) continue;
+          if (label == this->Label(t, (side == 0) ? s - 1 : s + 1)) continue;
+          // Merge collinear boundary edges of the same label
+          t0 = t;
+          while ((t + 1 < n) && (this->Label(t + 1, s) == label) &&
+                 (this->Label(t + 1, (side == 0) ? s - 1 : s + 1) != label)) t++;
+          segment._label = label;
+          if (_vertical) {
+            segment._x1 = s + side;
+            segment._y1 = t0;
+            segment._x2 = s + side;
+            segment._y2 = t + 1;
+          } else {
+            segment._x1 = t0;
+            segment._y1 = s + side;
+            segment._x2 = t + 1;
+            segment._y2 = s + side;
+          }
+          segments.push_back(segment);
+        }
+      }
+    }
+  }
+
+};
+
+void Viewer::DrawSegmentationContour(mirtk::GenericImage<int> *image, int version)
+{
+	int i, j, n;
+	double key[4];
+	unsigned char r, g, b;
+	std::map<int, std::vector<float> > lines;
+	std::map<int, std::vector<float> >::iterator it;
+
+	// Rebuild contours only if the segmentation or segment table changed
+	key[0] = version;
+	key[1] = _rview->_segmentTable->GetVersion();
+	key[2] = image->GetX();
+	key[3] = image->GetY();
+	if (_segmentationContour.IsValid(4, key) == false) {
+		_segmentationContour.Begin(GL_LINES, 4, key);
+
+		LabelBoundaries body;
+		body._voxels = image->GetPointerToVoxels();
+		body._x      = image->GetX();
+		body._y      = image->GetY();
+		body._table  = _rview->_segmentTable;
+
+		// Horizontal boundaries along rows, vertical boundaries along columns
+		for (i = 0; i < 2; i++) {
+			body._vertical = (i == 1);
+			n = (body._vertical) ? body._x : body._y;
+			body._segments = new std::vector<LabelBoundarySegment>[n];
+			mirtk::parallel_for(mirtk::blocked_range<int>(0, n), body);
+
+			// Group segments by label
+			for (j = 0; j < n; j++) {
+				std::vector<LabelBoundarySegment>::const_iterator s;
+				for (s = body._segments[j].begin(); s != body._segments[j].end(); ++s) {
+					std::vector<float> &line = lines[s->_label];
+					line.push_back(s->_x1);
+					line.push_back(s->_y1);
+					line.push_back(s->_x2);
+					line.push_back(s->_y2);
 				}
 			}
+			delete[] body._segments;
+		}
+
+		// One line array with a single colour per label
+		for (it = lines.begin(); it != lines.end(); ++it) {
+			_rview->_segmentTable->GetColor(it->first, &r, &g, &b);
+			_segmentationContour.SetColor(r, g, b);
+			_segmentationContour.AddVertices(it->second.size() / 2, &it->second[0]);
 		}
 	}
+
+	glLineWidth(_rview->GetLineThickness());
+	_segmentationContour.Draw(_screenX1, _screenY1);
 	glLineWidth(1);
 }
 
 void Viewer::DrawTagGrid()
 {
-  int i, j;
-
-  // Set color
-  COLOR_GRID;
-  glLineWidth(_rview->GetLineThickness());
-
-  glBegin (GL_LINES);
-  for (j = 0; j < _NumberOfTagGridY; j++) {
-    for (i = 0; i < _NumberOfTagGridX - 1; i++) {
-      glVertex2f(_screenX1 + _AfterTagGridX[i    ][j], _screenY1 + _AfterTagGridY[i    ][j]);
-      glVertex2f(_screenX1 + _AfterTagGridX[i + 1][j], _screenY1 + _AfterTagGridY[i + 1][j]);
+  int i, j, p;
+  double key[1];
+
+  // Rebuild tag grid only if it was recomputed
+  key[0] = _tagGridVersion;
+  if (_tagGrid.IsValid(1, key) == false) {
+    _tagGrid.Begin(GL_LINES, 1, key);
+    _tagGrid.SetColor(RGB_GRID);
+    for (j = 0; j < _NumberOfTagGridY; j++) {
+      for (i = 0; i < _NumberOfTagGridX - 1; i++) {
+        p = i + j * _NumberOfTagGridX;
+        _tagGrid.AddVertex(_AfterTagGridX[p    ], _AfterTagGridY[p    ]);
+        _tagGrid.AddVertex(_AfterTagGridX[p + 1], _AfterTagGridY[p + 1]);
+      }
     }
-  }
-  for (j = 0; j < _NumberOfTagGridY - 1; j++) {
-    for (i = 0; i < _NumberOfTagGridX; i++) {
-      glVertex2f(_screenX1 + _AfterTagGridX[i][j    ], _screenY1 + _AfterTagGridY[i][j    ]);
-      glVertex2f(_screenX1 + _AfterTagGridX[i][j + 1], _screenY1 + _AfterTagGridY[i][j + 1]);
+    for (j = 0; j < _NumberOfTagGridY - 1; j++) {
+      for (i = 0; i < _NumberOfTagGridX; i++) {
+        p = i + j * _NumberOfTagGridX;
+        _tagGrid.AddVertex(_AfterTagGridX[p                    ], _AfterTagGridY[p                    ]);
+        _tagGrid.AddVertex(_AfterTagGridX[p + _NumberOfTagGridX], _AfterTagGridY[p + _NumberOfTagGridX]);
+      }
     }
   }
-  glEnd();
+
+  glLineWidth(_rview->GetLineThickness());
+  _tagGrid.Draw(_screenX1, _screenY1);
   glLineWidth(1);
 }
 
 void Viewer::DrawGrid()
 {
-	int i, j;
-
-	// Set color
-	COLOR_GRID;
-
-	glLineWidth(_rview->GetLineThickness());
-
-	glBegin (GL_LINES);
-	for (j = 0; j < _NumberOfY; j++) {
-		for (i = 0; i < _NumberOfX - 1; i++) {
-			glVertex2f(_screenX1 + _AfterGridX[i    ][j], _screenY1 + _AfterGridY[i    ][j]);
-			glVertex2f(_screenX1 + _AfterGridX[i + 1][j], _screenY1 + _AfterGridY[i + 1][j]);
+	int i, j, p;
+	double key[1];
+
+	// Rebuild deformation grid only if it was recomputed
+	key[0] = _deformationVersion;
+	if (_deformationGrid.IsValid(1, key) == false) {
+		_deformationGrid.Begin(GL_LINES, 1, key);
+		_deformationGrid.SetColor(RGB_GRID);
+		for (j = 0; j < _NumberOfY; j++) {
+			for (i = 0; i < _NumberOfX - 1; i++) {
+				p = i + j * _NumberOfX;
+				_deformationGrid.AddVertex(_AfterGridX[p    ], _AfterGridY[p    ]);
+				_deformationGrid.AddVertex(_AfterGridX[p + 1], _AfterGridY[p + 1]);
+			}
 		}
-	}
-	for (j = 0; j < _NumberOfY - 1; j++) {
-		for (i = 0; i < _NumberOfX; i++) {
-			glVertex2f(_screenX1 + _AfterGridX[i][j    ], _screenY1 + _AfterGridY[i][j    ]);
-			glVertex2f(_screenX1 + _AfterGridX[i][j + 1], _screenY1 + _AfterGridY[i][j + 1]);
+		for (j = 0; j < _NumberOfY - 1; j++) {
+			for (i = 0; i < _NumberOfX; i++) {
+				p = i + j * _NumberOfX;
+				_deformationGrid.AddVertex(_AfterGridX[p             ], _AfterGridY[p             ]);
+				_deformationGrid.AddVertex(_AfterGridX[p + _NumberOfX], _AfterGridY[p + _NumberOfX]);
+			}
 		}
 	}
-	glEnd();
 
+	glLineWidth(_rview->GetLineThickness());
+	_deformationGrid.Draw(_screenX1, _screenY1);
 	glLineWidth(1);
 }
 
 void Viewer::DrawArrows()
 {
-	int i, j;
-
-	// Set color
-	COLOR_ARROWS;
-
-	for (j = 0; j < _NumberOfY; j++) {
-		for (i = 0; i < _NumberOfX; i++) {
-			glBegin (GL_LINES);
-			glVertex2f(_screenX1 + _BeforeX[i][j], _screenY1 + _BeforeY[i][j]);
-			glVertex2f(_screenX1 + _AfterX[i][j], _screenY1 + _AfterY[i][j]);
-			glEnd();
-			float dx = _AfterX[i][j] - _BeforeX[i][j];
-			float dy = _AfterY[i][j] - _BeforeY[i][j];
+	int p;
+	double key[1];
+
+	// Rebuild deformation arrows only if they were recomputed
+	key[0] = _deformationVersion;
+	if (_deformationArrows.IsValid(1, key) == false) {
+		_deformationArrows.Begin(GL_LINES, 1, key);
+		_deformationArrows.SetColor(RGB_ARROWS);
+		_deformationArrowHeads.Begin(GL_TRIANGLES, 1, key);
+		_deformationArrowHeads.SetColor(RGB_ARROWS);
+		for (p = 0; p < _NumberOfX * _NumberOfY; p++) {
+			_deformationArrows.AddVertex(_BeforeX[p], _BeforeY[p]);
+			_deformationArrows.AddVertex(_AfterX[p], _AfterY[p]);
+			float dx = _AfterX[p] - _BeforeX[p];
+			float dy = _AfterY[p] - _BeforeY[p];
 			float fat_factor = 2.0;
 			float line_len = sqrt(dx * dx + dy * dy);
 			float archor_width = line_len / 6.0;
@@ -773,40 +1030,42 @@ void Viewer::DrawArrows()
 				float add2dx = (dy * factor / (2 * fat_factor));
 				float add2dy = (-dx * factor / (2 * fat_factor));
 				mirtk::Point point[3];
-				point[0]._x = _screenX1 + _AfterX[i][j];
-				point[0]._y = _screenY1 + _AfterY[i][j];
+				point[0]._x = _AfterX[p];
+				point[0]._y = _AfterY[p];
 				point[1]._x = point[0]._x - add1dx + add2dx;
 				point[1]._y = point[0]._y - add1dy + add2dy;
 				point[2]._x = point[0]._x - add1dx - add2dx;
 				point[2]._y = point[0]._y - add1dy - add2dy;
-				glBegin (GL_POLYGON);
-				glVertex2f(point[0]._x, point[0]._y);
-				glVertex2f(point[1]._x, point[1]._y);
-				glVertex2f(point[2]._x, point[2]._y);
-				glEnd();
+				_deformationArrowHeads.AddVertex(point[0]._x, point[0]._y);
+				_deformationArrowHeads.AddVertex(point[1]._x, point[1]._y);
+				_deformationArrowHeads.AddVertex(point[2]._x, point[2]._y);
 			}
 		}
 	}
+
+	_deformationArrows.Draw(_screenX1, _screenY1);
+	_deformationArrowHeads.Draw(_screenX1, _screenY1);
 }
 
 void Viewer::DrawPoints()
 {
-	int i, j;
-
-	// Adjust pointsize
-	glPointSize((GLfloat) 3);
-
-	// Draw active and passive points
-	glBegin (GL_POINTS);
-	for (j = 0; j < _NumberOfY; j++) {
-		for (i = 0; i < _NumberOfX; i++) {
+	int p;
+	double key[1];
+
+	// Rebuild control points only if they were recomputed
+	key[0] = _deformationVersion;
+	if (_deformationPoints.IsValid(1, key) == false) {
+		_deformationPoints.Begin(GL_POINTS, 1, key);
+		for (p = 0; p < _NumberOfX * _NumberOfY; p++) {
 			// Set color
-			status_glColor(_CPStatus[i][j]);
-			// Draw point
-			glVertex2f(_screenX1 + _BeforeX[i][j], _screenY1 + _BeforeY[i][j]);
+			status_color(_CPStatus[p], _deformationPoints);
+			_deformationPoints.AddVertex(_BeforeX[p], _BeforeY[p]);
 		}
 	}
-	glEnd();
+
+	// Adjust pointsize
+	glPointSize((GLfloat) 3);
+	_deformationPoints.Draw(_screenX1, _screenY1);
 }
 
 void Viewer::DrawLandmarks(mirtk::PointSet &landmarks, std::set<int> &ids, mirtk::GreyImage *image, int bTarget, int bAll)
@@ -825,8 +1084,8 @@ void Viewer::DrawLandmarks(mirtk::PointSet &landmarks, std::set<int> &ids, mirtk
       // Transform point
       if (!bTarget && _rview->GetSourceTransformApply()) {
         const bool inv = !_rview->GetSourceTransformInvert();
-        if (inv) _rview->_sourceTransform->Inverse  (p);
-        else     _rview->_sourceTransform->Transform(p);
+        if (inv) _rview->InverseTransform(p._x, p._y, p._z);
+        else     _rview->Transform(p._x, p._y, p._z);
       }
       // Draw point
       if (image->IsInFOV(p._x, p._y, p._z)) {
@@ -851,8 +1110,8 @@ void Viewer::DrawLandmarks(mirtk::PointSet &landmarks, std::set<int> &ids, mirtk
     // Transform point
     if (!bTarget && _rview->GetSourceTransformApply()) {
       const bool inv = !_rview->GetSourceTransformInvert();
-      if (inv) _rview->_sourceTransform->Inverse  (p);
-      else     _rview->_sourceTransform->Transform(p);
+      if (inv) _rview->InverseTransform(p._x, p._y, p._z);
+      else     _rview->Transform(p._x, p._y, p._z);
     }
     // Draw point
     if (image->IsInFOV(p._x, p._y, p._z)) {
@@ -879,7 +1138,7 @@ void Viewer::DrawCorrespondences(mirtk::PointSet &target, mirtk::PointSet &sourc
     if (i >= source.Size()) continue;
     p1 = target(i);
     p2 = source(i);
-    _rview->_sourceTransform->Inverse(p1._x, p1._y, p1._z);
+    _rview->InverseTransform(p1._x, p1._y, p1._z);
     if (image->IsInFOV(p1._x, p1._y, p1._z) &&
         image->IsInFOV(p2._x, p2._y, p2._z)) {
       image->WorldToImage(p1);
@@ -904,7 +1163,7 @@ void Viewer::DrawCorrespondences(mirtk::PointSet &target, mirtk::PointSet &sourc
     if (*id < 0 || *id >= target.Size() || *id >= source.Size()) continue;
     p1 = target(*id);
     p2 = source(*id);
-    _rview->_sourceTransform->Inverse(p1._x, p1._y, p1._z);
+    _rview->InverseTransform(p1._x, p1._y, p1._z);
     if (image->IsInFOV(p1._x, p1._y, p1._z) &&
         image->IsInFOV(p2._x, p2._y, p2._z)) {
       image->WorldToImage(p1);
@@ -917,14 +1176,105 @@ void Viewer::DrawCorrespondences(mirtk::PointSet &target, mirtk::PointSet &sourc
   }
 }
 
-void Viewer::DrawImage(Color *drawable)
+void Viewer::DrawImage(Color *drawable, bool modified)
 {
-	// Set raster position
-	glRasterPos2f(_screenX1, _screenY1);
+	int i, j, y1, y2, width, height;
+	bool changed;
+	unsigned char *ptr;
+
+	width  = this->GetWidth();
+	height = this->GetHeight();
+
+	// (Re)create texture if the size changed or the OpenGL context is new
+	if ((_texture == 0) || (glIsTexture(_texture) != GL_TRUE) ||
+			(width != _textureWidth) || (height != _textureHeight)) {
+		if (_texture == 0) glGenTextures(1, &_texture);
+
+		// Power of two sizes are supported by every implementation
+		for (_textureX = 1; _textureX < width; _textureX *= 2);
+		for (_textureY = 1; _textureY < height; _textureY *= 2);
+		_textureWidth = width;
+		_textureHeight = height;
+
+		glBindTexture(GL_TEXTURE_2D, _texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _textureX, _textureY, 0,
+				GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+		// Texture contents are undefined, upload everything
+		delete[] _textureBuffer;
+		_textureBuffer = new unsigned char[4 * width * height];
+		for (i = 0; i < 4 * width * height; i++) _textureBuffer[i] = 255;
+		for (i = 0; i < width * height; i++) {
+			_textureBuffer[4*i]   = drawable[i].r;
+			_textureBuffer[4*i+1] = drawable[i].g;
+			_textureBuffer[4*i+2] = drawable[i].b;
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA,
+				GL_UNSIGNED_BYTE, _textureBuffer);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	} else {
+		glBindTexture(GL_TEXTURE_2D, _texture);
+
+		if (modified == true) {
+			// Find the band of rows which actually changed
+			y1 = -1;
+			y2 = -1;
+			for (j = 0; j < height; j++) {
+				changed = false;
+				ptr = &_textureBuffer[4 * width * j];
+				for (i = 0; i < width; i++) {
+					if ((ptr[0] != drawable->r) || (ptr[1] != drawable->g) ||
+							(ptr[2] != drawable->b)) {
+						ptr[0] = drawable->r;
+						ptr[1] = drawable->g;
+						ptr[2] = drawable->b;
+						changed = true;
+					}
+					ptr += 4;
+					drawable++;
+				}
+				if (changed == true) {
+					if (y1 < 0) y1 = j;
+					y2 = j;
+				}
+			}
 
-	// Draw pixelmap
-	glDrawPixels(this->GetWidth(), this->GetHeight(), GL_RGB, GL_UNSIGNED_BYTE,
-			drawable);
+			// Upload changed rows only
+			if (y1 >= 0) {
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y1, width, y2 - y1 + 1, GL_RGBA,
+						GL_UNSIGNED_BYTE, &_textureBuffer[4 * width * y1]);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			}
+		}
+	}
+
+	// Blit texture one texel per pixel into the viewport of this viewer
+	glViewport(_screenX1, _screenY1, width, height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	gluOrtho2D(0, width, 0, height);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glEnable(GL_TEXTURE_2D);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0, 0);
+	glVertex2f(0, 0);
+	glTexCoord2f(width / (float) _textureX, 0);
+	glVertex2f(width, 0);
+	glTexCoord2f(width / (float) _textureX, height / (float) _textureY);
+	glVertex2f(width, height);
+	glTexCoord2f(0, height / (float) _textureY);
+	glVertex2f(0, height);
+	glEnd();
+	glDisable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Viewer::DrawROI(mirtk::GreyImage *image, double x1, double y1, double z1,